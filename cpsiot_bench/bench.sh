@@ -0,0 +1,125 @@
+#!/bin/bash
+
+# Runs leader elections on RIOT native: one master and N workers connected
+# through the local ZEP hub. Each run goes through discovery, topology,
+# start and results on the master, and appends one CSV row.
+# Author: Michael Conard
+
+WORKERS=6
+RUNS=1
+LOSS=0
+TIMEOUT=120
+CSV=bench.csv
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+HUB=${HUB:-$HERE/bin/zep_hub}
+MASTER=${MASTER:-$HERE/../cpsiot_masternode/bin/native/master_node.elf}
+WORKER=${WORKER:-$HERE/../cpsiot_workernode/bin/native/worker_node.elf}
+LOGDIR=${LOGDIR:-$HERE/bin/logs}
+HUB_PORT=${HUB_PORT:-17754}
+FIRST_PORT=${FIRST_PORT:-17760}
+
+usage() {
+    echo "Usage: bench.sh [-n workers] [-r runs] [-l loss-percent] [-t timeout-sec] [-o csv]"
+}
+
+while getopts "n:r:l:t:o:h" opt; do
+    case "$opt" in
+        n) WORKERS="$OPTARG" ;;
+        r) RUNS="$OPTARG" ;;
+        l) LOSS="$OPTARG" ;;
+        t) TIMEOUT="$OPTARG" ;;
+        o) CSV="$OPTARG" ;;
+        h) usage; exit 0 ;;
+        *) usage; exit 1 ;;
+    esac
+done
+
+for f in "$HUB" "$MASTER" "$WORKER"; do
+    if [ ! -x "$f" ]
+    then
+        echo "bench: $f not found, run make bench (or make firmware) first"
+        exit 1
+    fi
+done
+
+if [ ! -f "$CSV" ]
+then
+    echo "run,workers,loss,reported,leaders,convergence_median_us,convergence_max_us,messages_total,messages_max,rounds_max,network_convergence_us,wall_s" > "$CSV"
+fi
+
+PIDS=()
+cleanup() {
+    if [ ${#PIDS[@]} -gt 0 ]
+    then
+        kill "${PIDS[@]}" 2>/dev/null
+        wait "${PIDS[@]}" 2>/dev/null
+    fi
+    PIDS=()
+    exec 3>&-
+}
+trap 'cleanup; exit 1' INT TERM
+
+for run in $(seq 1 "$RUNS"); do
+    DIR="$LOGDIR/run$run"
+    rm -rf "$DIR"
+    mkdir -p "$DIR"
+
+    # the RIOT shells read stdin, a FIFO nobody writes to keeps them idle
+    mkfifo "$DIR/stdin"
+    exec 3<>"$DIR/stdin"
+
+    "$HUB" -p "$HUB_PORT" -c "$FIRST_PORT" -n $((WORKERS + 1)) -l "$LOSS" -s "$run" > "$DIR/hub.log" 2>&1 &
+    PIDS+=($!)
+
+    # workers first, the master starts discovering as soon as it boots
+    for i in $(seq 1 "$WORKERS"); do
+        "$WORKER" -z "[::1]:$((FIRST_PORT + i)),[::1]:$HUB_PORT" < "$DIR/stdin" > "$DIR/worker$i.log" 2>&1 &
+        PIDS+=($!)
+    done
+    sleep 1
+
+    START=$(date +%s.%N)
+    "$MASTER" -z "[::1]:$FIRST_PORT,[::1]:$HUB_PORT" < "$DIR/stdin" > "$DIR/master.log" 2>&1 &
+    PIDS+=($!)
+
+    DONE=0
+    for t in $(seq 1 "$TIMEOUT"); do
+        if grep -q "All nodes have reported" "$DIR/master.log"
+        then
+            DONE=1
+            break
+        fi
+        sleep 1
+    done
+    WALL=$(awk -v s="$START" -v e="$(date +%s.%N)" 'BEGIN { printf "%.1f", e - s }')
+    cleanup
+
+    # the election's reports only, re-elections after a lost heartbeat print the same lines
+    RESULTS="$DIR/results.log"
+    sed '/All nodes have reported/q' "$DIR/master.log" > "$RESULTS"
+
+    # per node lines of the master, e.g. "UDP: Node fe80::1 finished in 1234 microseconds"
+    REPORTED=$(grep -c "finished in" "$RESULTS")
+    LEADERS=$(awk '/elected .* as leader/ { print $(NF-2) }' "$RESULTS" | sort -u | wc -l)
+    CONV=$(awk '/finished in/ { print $(NF-1) }' "$RESULTS" | sort -n |
+           awk '{ v[NR] = $1 } END { if (NR) printf "%d,%d", v[int((NR + 1) / 2)], v[NR]; else printf "," }')
+    MSGS=$(awk '/exchanged/ { s += $(NF-1); if ($(NF-1) > m) m = $(NF-1) } END { printf "%d,%d", s, m }' "$RESULTS")
+    ROUNDS=$(awk '/needed .* rounds/ { if ($(NF-1) > m) m = $(NF-1) } END { printf "%d", m }' "$RESULTS")
+    # first start to last node done, on the master's timebase
+    NETCONV=$(awk '/network converged in/ { print $5 }' "$DIR/master.log")
+
+    # the columns come from the master's log lines, say so when they are missing
+    if [ "$DONE" -eq 0 ]
+    then
+        echo "bench: run $run: no \"All nodes have reported\" from the master within $TIMEOUT s"
+    fi
+    if [ "$REPORTED" -eq 0 ] && [ -s "$DIR/master.log" ]
+    then
+        echo "bench: run $run: no \"UDP: Node <addr> finished in <usec> microseconds\" lines in $DIR/master.log"
+    fi
+
+    echo "$run,$WORKERS,$LOSS,$REPORTED,$LEADERS,$CONV,$MSGS,$ROUNDS,$NETCONV,$WALL" >> "$CSV"
+    echo "bench: run $run: $REPORTED/$WORKERS nodes reported, $LEADERS distinct leader(s), convergence median,max $CONV us, messages total,max $MSGS, logs in $DIR"
+    rm -f "$DIR/stdin"
+done
@@ -0,0 +1,148 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Local stand-in for the radio of RIOT native instances.
+ *
+ * Every native node runs socket_zep and sends its 802.15.4 frames as ZEP
+ * datagrams to this hub, which repeats each one to every other node, like a
+ * single shared channel. Nodes are the configured client ports on [::1]
+ * plus any address a datagram arrives from. An optional loss rate is
+ * applied per receiver. No root, tap devices or network are needed.
+ */
+
+// Standard C includes
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define HUB_PORT                (17754)
+#define MAX_PEERS               (256)
+#define MAX_FRAME_LEN           (256)
+
+// State variables
+static struct sockaddr_in6 peers[MAX_PEERS];
+static int numPeers = 0;
+static volatile sig_atomic_t stop = 0;
+
+static void onSignal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+// Purpose: find a peer, registering it if it is new
+//
+// addr sockaddr_in6*, the peer's address
+// return its index, -1 if the table is full
+static int findPeer(const struct sockaddr_in6 *addr) {
+    for (int i = 0; i < numPeers; i++) {
+        if (peers[i].sin6_port == addr->sin6_port &&
+            memcmp(&peers[i].sin6_addr, &addr->sin6_addr, sizeof(addr->sin6_addr)) == 0) {
+            return i;
+        }
+    }
+    if (numPeers == MAX_PEERS) {
+        return -1;
+    }
+    peers[numPeers] = *addr;
+    return numPeers++;
+}
+
+static void usage(const char *name) {
+    printf("Usage: %s [-p port] [-c first-client-port] [-n clients] [-l loss-percent] [-s seed]\n", name);
+}
+
+int main(int argc, char **argv) {
+    uint16_t port = HUB_PORT;
+    uint16_t firstClient = 0;
+    int numClients = 0;
+    double loss = 0.0;
+    unsigned seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:c:n:l:s:h")) != -1) {
+        switch (opt) {
+            case 'p': port = (uint16_t)atoi(optarg); break;
+            case 'c': firstClient = (uint16_t)atoi(optarg); break;
+            case 'n': numClients = atoi(optarg); break;
+            case 'l': loss = atof(optarg) / 100.0; break;
+            case 's': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+    srand(seed);
+
+    int sock = socket(AF_INET6, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("HUB: socket");
+        return 1;
+    }
+    struct sockaddr_in6 local = { .sin6_family = AF_INET6, .sin6_port = htons(port), .sin6_addr = in6addr_loopback };
+    if (bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+        perror("HUB: bind");
+        return 1;
+    }
+
+    // the nodes only talk once the master pings them, so they are known up front
+    for (int i = 0; i < numClients; i++) {
+        struct sockaddr_in6 client = { .sin6_family = AF_INET6, .sin6_port = htons(firstClient + i),
+                                       .sin6_addr = in6addr_loopback };
+        findPeer(&client);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    printf("HUB: listening on [::1]:%u, %d clients\n", port, numPeers);
+    fflush(stdout);
+
+    uint64_t framesIn = 0, framesOut = 0, framesLost = 0;
+    uint8_t frame[MAX_FRAME_LEN];
+    while (!stop) {
+        struct sockaddr_in6 from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t len = recvfrom(sock, frame, sizeof(frame), 0, (struct sockaddr *)&from, &fromLen);
+        if (len < 0) {
+            if (errno != EINTR) {
+                perror("HUB: recvfrom");
+            }
+            continue;
+        }
+        framesIn++;
+
+        int sender = findPeer(&from);
+        for (int i = 0; i < numPeers; i++) {
+            if (i == sender) {
+                continue;
+            }
+            if (loss > 0 && rand() < loss * ((double)RAND_MAX + 1)) {
+                framesLost++;
+                continue;
+            }
+            if (sendto(sock, frame, len, 0, (struct sockaddr *)&peers[i], sizeof(peers[i])) == len) {
+                framesOut++;
+            }
+        }
+    }
+
+    printf("HUB: %d peers, frames in %"PRIu64", repeated %"PRIu64", lost %"PRIu64"\n",
+           numPeers, framesIn, framesOut, framesLost);
+    close(sock);
+    return 0;
+}
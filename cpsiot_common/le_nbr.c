@@ -0,0 +1,242 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Hashed neighbor table, see le_nbr.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "le_nbr.h"
+
+// Purpose: FNV-1a over the address, reduced to a home slot
+//
+// addr ipv6_addr_t*, the address to hash
+static unsigned homeSlot(const ipv6_addr_t *addr) {
+    uint32_t h = 2166136261u;
+    for (unsigned i = 0; i < sizeof(addr->u8); i++) {
+        h = (h ^ addr->u8[i]) * 16777619u;
+    }
+    return h % LE_NBR_HASH_SIZE;
+}
+
+// Purpose: find the hash slot that holds an address
+//
+// return the slot, or -1 if the address is not in the table
+static int findSlot(const le_nbr_table_t *table, const ipv6_addr_t *addr) {
+    unsigned s = homeSlot(addr);
+    while (table->slots[s] != 0) {
+        if (ipv6_addr_equal(&table->entries[table->slots[s] - 1].addr, addr)) {
+            return s;
+        }
+        s = (s + 1) % LE_NBR_HASH_SIZE;
+    }
+    return -1;
+}
+
+// Purpose: empty slot s and pull later members of its probe chain back,
+// so lookups never stop early at the hole (no tombstones needed)
+static void clearSlot(le_nbr_table_t *table, unsigned s) {
+    unsigned j = s;
+    while (1) {
+        j = (j + 1) % LE_NBR_HASH_SIZE;
+        if (table->slots[j] == 0) {
+            break;
+        }
+        unsigned home = homeSlot(&table->entries[table->slots[j] - 1].addr);
+        // the entry at j may move into s unless its home lies cyclically in (s, j]
+        bool stays = (s <= j) ? (s < home && home <= j) : (s < home || home <= j);
+        if (!stays) {
+            table->slots[s] = table->slots[j];
+            s = j;
+        }
+    }
+    table->slots[s] = 0;
+}
+
+// Purpose: empty the table
+//
+// table le_nbr_table_t*, the table to reset
+void le_nbr_init(le_nbr_table_t *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+// Purpose: register a neighbor and cache its UDP endpoint
+//
+// table le_nbr_table_t*, the table to add to
+// addr ipv6_addr_t*, the neighbor's address
+// link uint8_t, LE_NBR_IN and/or LE_NBR_OUT, added to those of a known neighbor
+// port uint16_t, the neighbor's UDP port
+// netif uint16_t, interface to reach a link-local neighbor on
+// return the entry index (also if already present), or -1 if the table is full
+int le_nbr_add(le_nbr_table_t *table, const ipv6_addr_t *addr, uint8_t link, uint16_t port, uint16_t netif) {
+    int s = findSlot(table, addr);
+    if (s >= 0) {
+        le_nbr_t *nbr = &table->entries[table->slots[s] - 1];
+        if ((link & LE_NBR_IN) && !(nbr->link & LE_NBR_IN)) {
+            table->numIn++;
+        }
+        nbr->link |= link;
+        return table->slots[s] - 1;
+    }
+    if (table->count >= LE_MAX_NEIGHBORS) {
+        return -1;
+    }
+
+    uint16_t idx = table->count++;
+    le_nbr_t *nbr = &table->entries[idx];
+    memset(nbr, 0, sizeof(*nbr));
+    nbr->addr = *addr;
+    nbr->link = link;
+    if (link & LE_NBR_IN) {
+        table->numIn++;
+    }
+    nbr->ep.family = AF_INET6;
+    memcpy(nbr->ep.addr.ipv6, addr, sizeof(nbr->ep.addr.ipv6));
+    nbr->ep.port = port;
+    if (ipv6_addr_is_link_local(addr)) {
+        nbr->ep.netif = netif;
+    }
+
+    unsigned slot = homeSlot(addr);
+    while (table->slots[slot] != 0) {
+        slot = (slot + 1) % LE_NBR_HASH_SIZE;
+    }
+    table->slots[slot] = idx + 1;
+    return idx;
+}
+
+// Purpose: look up a neighbor by address
+//
+// return the entry index, or -1 if it is not a neighbor
+int le_nbr_find(const le_nbr_table_t *table, const ipv6_addr_t *addr) {
+    int s = findSlot(table, addr);
+    return (s < 0) ? -1 : table->slots[s] - 1;
+}
+
+// Purpose: drop a neighbor, the last entry moves into its place
+//
+// return 0 on success, -1 if it was not a neighbor
+int le_nbr_remove(le_nbr_table_t *table, const ipv6_addr_t *addr) {
+    int s = findSlot(table, addr);
+    if (s < 0) {
+        return -1;
+    }
+    uint16_t idx = table->slots[s] - 1;
+    if (table->entries[idx].link & LE_NBR_IN) {
+        table->numIn--;
+    }
+    clearSlot(table, s);
+
+    uint16_t last = --table->count;
+    if (idx != last) {
+        table->entries[idx] = table->entries[last];
+        table->slots[findSlot(table, &table->entries[idx].addr)] = idx + 1;
+    }
+    return 0;
+}
+
+// Purpose: start a new round, forgetting the m values heard for older rounds;
+// neighbors that are already ahead keep theirs, and so do neighbors that
+// announced to stay quiet through this round, their last ack stands in
+//
+// table le_nbr_table_t*, the neighbors
+// round uint16_t, the round that starts
+// implied int*, set to the number of neighbors whose report is implied
+// return the number of neighbors that already reported for round
+int le_nbr_reset_round(le_nbr_table_t *table, uint16_t round, int *implied) {
+    int reported = 0;
+    *implied = 0;
+    for (uint16_t i = 0; i < table->count; i++) {
+        le_nbr_t *nbr = &table->entries[i];
+        nbr->implied = false;
+        if (nbr->m != 0 && nbr->round >= round) {
+            reported++;
+        } else if (nbr->m != 0 && nbr->quietUntil >= round) {
+            nbr->implied = true;
+            (*implied)++;
+        } else {
+            nbr->m = 0;
+        }
+    }
+    return reported;
+}
+
+// Purpose: forget everything learned in a run, the neighbors and their links
+// stay; response times are dropped too so every run starts from T1/T2,
+// unless a re-election within the run keeps them
+//
+// table le_nbr_table_t*, the table
+// keepRtt bool, keep the response time estimates
+void le_nbr_reset_run(le_nbr_table_t *table, bool keepRtt) {
+    for (uint16_t i = 0; i < table->count; i++) {
+        le_nbr_t *nbr = &table->entries[i];
+        nbr->m = 0;
+        nbr->round = 0;
+        nbr->hops = 0;
+        nbr->quietUntil = 0;
+        nbr->implied = false;
+        memset(&nbr->leader, 0, sizeof(nbr->leader));
+        if (keepRtt) {
+            continue;
+        }
+        nbr->srtt = 0;
+        nbr->rttvar = 0;
+        nbr->rttSamples = 0;
+    }
+}
+
+// Purpose: fold a response time sample into the neighbor's estimate,
+// EWMA with gains 1/8 (mean) and 1/4 (deviation) as in TCP (RFC 6298)
+//
+// nbr le_nbr_t*, the neighbor that answered
+// sample uint32_t, usec from our request to its answer
+void le_nbr_rtt_sample(le_nbr_t *nbr, uint32_t sample) {
+    if (nbr->rttSamples == 0) {
+        nbr->srtt = sample;
+        nbr->rttvar = sample / 2;
+    } else {
+        uint32_t err = (sample > nbr->srtt) ? (sample - nbr->srtt) : (nbr->srtt - sample);
+        nbr->rttvar = nbr->rttvar - (nbr->rttvar >> 2) + (err >> 2);
+        nbr->srtt = nbr->srtt - (nbr->srtt >> 3) + (sample >> 3);
+    }
+    if (nbr->rttSamples < UINT16_MAX) {
+        nbr->rttSamples++;
+    }
+}
+
+// Purpose: how long to wait for the slowest neighbor, srtt + 4 * rttvar
+//
+// table le_nbr_table_t*, the neighbors to cover
+// floor uint32_t, lower bound in usec
+// ceiling uint32_t, upper bound in usec
+// initial uint32_t, timeout to use before any neighbor has a sample
+// return the timeout in usec
+uint32_t le_nbr_rto(const le_nbr_table_t *table, uint32_t floor, uint32_t ceiling, uint32_t initial) {
+    uint32_t rto = 0;
+    bool sampled = false;
+
+    for (uint16_t i = 0; i < table->count; i++) {
+        const le_nbr_t *nbr = &table->entries[i];
+        if (nbr->rttSamples == 0) {
+            continue;
+        }
+        uint32_t t = nbr->srtt + 4 * nbr->rttvar;
+        if (t > rto) {
+            rto = t;
+        }
+        sampled = true;
+    }
+    if (!sampled) {
+        rto = initial;
+    }
+    if (rto < floor) {
+        rto = floor;
+    }
+    if (rto > ceiling) {
+        rto = ceiling;
+    }
+    return rto;
+}
@@ -0,0 +1,67 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Neighbor table of a worker node, keyed by binary IPv6 address.
+ *
+ * Entries are kept dense in entries[0..count) so the protocol can walk them
+ * per round, and an open addressing hash index maps an address to its entry
+ * in O(1) on every received le_ack. The capacity comes from the Makefile
+ * (LE_MAX_NEIGHBORS) so dense mesh and complete topologies fit.
+ */
+
+#ifndef LE_NBR_H
+#define LE_NBR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "net/ipv6/addr.h"
+#include "net/sock/udp.h"
+
+#ifndef LE_MAX_NEIGHBORS
+#define LE_MAX_NEIGHBORS        (8)
+#endif
+
+// hash index slots, kept at most half full so probe chains stay short
+#define LE_NBR_HASH_SIZE        (2 * LE_MAX_NEIGHBORS + 1)
+
+// direction of the link to a neighbor
+#define LE_NBR_IN               (0x01)  // we hear it, its le_ack counts
+#define LE_NBR_OUT              (0x02)  // we send to it
+#define LE_NBR_BOTH             (LE_NBR_IN | LE_NBR_OUT)
+
+typedef struct {
+    ipv6_addr_t addr;
+    sock_udp_ep_t ep;       // cached endpoint for unicast sends
+    uint8_t link;           // LE_NBR_IN and/or LE_NBR_OUT
+    uint16_t m;             // m value heard in the current round, 0 if none
+    uint16_t round;         // round of the last le_ack from this neighbor
+    ipv6_addr_t leader;     // leader reported with m
+    uint8_t hops;           // the neighbor's distance to that leader
+    uint16_t quietUntil;    // last round it announced to skip, its report is implied until then
+    bool implied;           // m stands in for an ack it skipped this round
+    uint32_t srtt;          // smoothed response time in usec
+    uint32_t rttvar;        // mean deviation of the response time in usec
+    uint16_t rttSamples;    // number of samples behind srtt, 0 if none yet
+    uint32_t heard;         // when the neighbor was last heard, autonomous discovery ages it out
+} le_nbr_t;
+
+typedef struct {
+    le_nbr_t entries[LE_MAX_NEIGHBORS];
+    uint16_t slots[LE_NBR_HASH_SIZE];   // entry index + 1, 0 marks an empty slot
+    uint16_t count;
+    uint16_t numIn;                     // entries with LE_NBR_IN, the answers a round waits for
+    volatile bool pinned;               // an election is counting rounds over the entries, the membership
+                                        // is frozen: none may be added or removed, fields may change
+} le_nbr_table_t;
+
+void le_nbr_init(le_nbr_table_t *table);
+int le_nbr_add(le_nbr_table_t *table, const ipv6_addr_t *addr, uint8_t link, uint16_t port, uint16_t netif);
+int le_nbr_find(const le_nbr_table_t *table, const ipv6_addr_t *addr);
+int le_nbr_remove(le_nbr_table_t *table, const ipv6_addr_t *addr);
+int le_nbr_reset_round(le_nbr_table_t *table, uint16_t round, int *implied);
+void le_nbr_reset_run(le_nbr_table_t *table, bool keepRtt);
+void le_nbr_rtt_sample(le_nbr_t *nbr, uint32_t sample);
+uint32_t le_nbr_rto(const le_nbr_table_t *table, uint32_t floor, uint32_t ceiling, uint32_t initial);
+
+#endif /* LE_NBR_H */
@@ -0,0 +1,107 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Time synchronization, see le_sync.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "le_sync.h"
+
+// a fitted skew beyond this is taken for an outlier, crystals stay well within it
+#define SKEW_MAX_PPM            (1000)
+
+// Purpose: forget all samples, conversions are the identity until the first one
+//
+// sync le_sync_t*, the clock to reset
+void le_sync_init(le_sync_t *sync) {
+    memset(sync, 0, sizeof(*sync));
+}
+
+// Purpose: refit offset and skew through the stored samples by least squares,
+// relative to the newest sample so the sums stay small
+//
+// sync le_sync_t*, the clock
+// newest int, index of the newest sample
+static void fit(le_sync_t *sync, int newest) {
+    uint32_t refLocal = sync->local[newest];
+    uint32_t refOffset = sync->master[newest] - refLocal;
+    int64_t sx = 0, sy = 0;
+
+    for (int i = 0; i < sync->count; i++) {
+        sx += (int32_t)(sync->local[i] - refLocal);
+        sy += (int32_t)(sync->master[i] - sync->local[i] - refOffset);
+    }
+    int64_t mx = sx / sync->count;
+    int64_t my = sy / sync->count;
+
+    int64_t sxx = 0, sxy = 0;
+    for (int i = 0; i < sync->count; i++) {
+        int64_t dx = (int32_t)(sync->local[i] - refLocal) - mx;
+        int64_t dy = (int32_t)(sync->master[i] - sync->local[i] - refOffset) - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+
+    // samples less than about a millisecond apart say nothing about the rate
+    int64_t skew = (sxx >= 1000000) ? sxy / (sxx / 1000000) : 0;
+    if (skew > SKEW_MAX_PPM || skew < -SKEW_MAX_PPM) {
+        skew = 0;
+    }
+    sync->base = refLocal + (uint32_t)mx;
+    sync->offset = refOffset + (uint32_t)my;
+    sync->skewPpm = (int32_t)skew;
+}
+
+// Purpose: add a pair of simultaneous timestamps, replacing the oldest one
+//
+// sync le_sync_t*, the clock
+// local uint32_t, our clock
+// master uint32_t, the master's clock at the same moment
+void le_sync_sample(le_sync_t *sync, uint32_t local, uint32_t master) {
+    int i = sync->next;
+    sync->local[i] = local;
+    sync->master[i] = master;
+    sync->next = (sync->next + 1) % LE_SYNC_SAMPLES;
+    if (sync->count < LE_SYNC_SAMPLES) {
+        sync->count++;
+    }
+    fit(sync, i);
+}
+
+// Purpose: whether at least one sample relates the clocks
+bool le_sync_valid(const le_sync_t *sync) {
+    return sync->count > 0;
+}
+
+// Purpose: convert one of our timestamps to the master's clock
+uint32_t le_sync_to_master(const le_sync_t *sync, uint32_t local) {
+    int64_t dx = (int32_t)(local - sync->base);
+    return local + sync->offset + (uint32_t)(int32_t)(dx * sync->skewPpm / 1000000);
+}
+
+// Purpose: convert a time in the master's clock to ours, e.g. a scheduled start
+uint32_t le_sync_to_local(const le_sync_t *sync, uint32_t master) {
+    // the skew term is tiny, one correction from the offset-only guess suffices
+    uint32_t local = master - sync->offset;
+    return local - (le_sync_to_master(sync, local) - master);
+}
+
+// Purpose: offset and round trip of one two-way exchange, NTP style; the
+// forward and return delays cancel as far as they are equal
+//
+// t0 uint32_t, master clock when the ping was sent
+// t1 uint32_t, worker clock when it arrived
+// t2 uint32_t, worker clock when the pong was sent
+// t3 uint32_t, master clock when the pong arrived
+// rtt uint32_t*, set to the round trip without the worker's turnaround
+// return the worker clock minus the master clock, modulo 2^32
+uint32_t le_sync_ntp(uint32_t t0, uint32_t t1, uint32_t t2, uint32_t t3, uint32_t *rtt) {
+    *rtt = (t3 - t0) - (t2 - t1);
+    int32_t forward = (int32_t)(t1 - t0);
+    int32_t back = (int32_t)(t2 - t3);
+    return (uint32_t)(forward / 2 + back / 2);
+}
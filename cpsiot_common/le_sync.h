@@ -0,0 +1,46 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Time synchronization shared by the master and worker nodes.
+ *
+ * The master's xtimer clock is the common timebase. The master measures each
+ * worker's offset once at discovery (le_sync_ntp on the ping/pong timestamps)
+ * and then floods a sync beacon with its clock every LE_SYNC_PERIOD_USEC.
+ * A worker keeps the last LE_SYNC_SAMPLES (local, master) pairs and fits
+ * offset and skew through them by least squares, FTSP style, so it can turn
+ * its own timestamps into master time and back. Beacons are stamped in the
+ * UDP threads rather than at the MAC, so converted times carry the one-way
+ * beacon delay; it is about the same for every worker and cancels out of
+ * intervals measured across nodes.
+ */
+
+#ifndef LE_SYNC_H
+#define LE_SYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef LE_SYNC_SAMPLES
+#define LE_SYNC_SAMPLES         (8)
+#endif
+
+typedef struct {
+    uint32_t local[LE_SYNC_SAMPLES];    // our clock at each sample
+    uint32_t master[LE_SYNC_SAMPLES];   // master clock at the same moment
+    uint8_t count;
+    uint8_t next;                       // oldest sample, overwritten next
+
+    // the fit, master = local + offset + skew * (local - base)
+    uint32_t base;
+    uint32_t offset;
+    int32_t skewPpm;                    // how much faster the master's clock runs
+} le_sync_t;
+
+void le_sync_init(le_sync_t *sync);
+void le_sync_sample(le_sync_t *sync, uint32_t local, uint32_t master);
+bool le_sync_valid(const le_sync_t *sync);
+uint32_t le_sync_to_master(const le_sync_t *sync, uint32_t local);
+uint32_t le_sync_to_local(const le_sync_t *sync, uint32_t master);
+uint32_t le_sync_ntp(uint32_t t0, uint32_t t1, uint32_t t2, uint32_t t3, uint32_t *rtt);
+
+#endif /* LE_SYNC_H */
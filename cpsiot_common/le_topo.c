@@ -0,0 +1,261 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Topology generator, see le_topo.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "le_topo.h"
+
+static const char *topoNames[] = {
+    [LE_TOPO_LINE] = "line",
+    [LE_TOPO_RING] = "ring",
+    [LE_TOPO_GRID] = "grid",
+    [LE_TOPO_MESH] = "mesh",
+    [LE_TOPO_TREE] = "tree",
+    [LE_TOPO_STAR] = "star",
+    [LE_TOPO_COMPLETE] = "complete",
+};
+
+// Purpose: look up a topology by name
+//
+// name char*, one of line, ring, grid, mesh, tree (or binary-tree), star, complete
+// kind le_topo_kind_t*, set to the shape
+// return 0 on success, -1 for an unknown name
+int le_topo_parse(const char *name, le_topo_kind_t *kind) {
+    if (strcmp(name, "binary-tree") == 0) {
+        name = "tree";
+    }
+    for (unsigned i = 0; i < sizeof(topoNames) / sizeof(topoNames[0]); i++) {
+        if (strcmp(name, topoNames[i]) == 0) {
+            *kind = (le_topo_kind_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Purpose: printable name of a topology
+const char *le_topo_name(le_topo_kind_t kind) {
+    return topoNames[kind];
+}
+
+// Purpose: hand the generator its storage
+//
+// topo le_topo_t*, the topology to set up
+// offsets uint32_t*, maxNodes + 1 entries
+// maxNodes uint32_t, largest topology that fits
+// adj uint16_t*, maxLinks entries
+// link uint8_t*, maxLinks entries
+// maxLinks uint32_t, two per link, e.g. 2 * maxNodes for a ring
+void le_topo_init(le_topo_t *topo, uint32_t *offsets, uint32_t maxNodes,
+                  uint16_t *adj, uint8_t *link, uint32_t maxLinks) {
+    memset(topo, 0, sizeof(*topo));
+    topo->offsets = offsets;
+    topo->adj = adj;
+    topo->link = link;
+    topo->maxNodes = maxNodes;
+    topo->maxLinks = maxLinks;
+}
+
+// Purpose: call link(topo, from, to) once for every link, uni links point
+// from the first node to the second
+//
+// topo le_topo_t*, the shape, size and grid dimensions
+// link function, counts or stores the link
+static void forEachLink(le_topo_t *topo, void (*link)(le_topo_t *, uint32_t, uint32_t)) {
+    uint32_t n = topo->numNodes;
+
+    switch (topo->kind) {
+        case LE_TOPO_LINE:
+        case LE_TOPO_RING:
+            for (uint32_t i = 0; i + 1 < n; i++) {
+                link(topo, i, i + 1);
+            }
+            if (topo->kind == LE_TOPO_RING && n > 2) {
+                link(topo, n - 1, 0);
+            }
+            break;
+        case LE_TOPO_GRID:
+        case LE_TOPO_MESH:
+            for (uint32_t r = 0; r < topo->rows; r++) {
+                for (uint32_t c = 0; c < topo->cols; c++) {
+                    uint32_t i = r * topo->cols + c;
+                    if (c + 1 < topo->cols) {
+                        link(topo, i, i + 1);
+                    }
+                    if (r + 1 < topo->rows) {
+                        link(topo, i, i + topo->cols);
+                    }
+                    // the mesh adds the diagonals
+                    if (topo->kind == LE_TOPO_MESH && r + 1 < topo->rows) {
+                        if (c + 1 < topo->cols) {
+                            link(topo, i, i + topo->cols + 1);
+                        }
+                        if (c > 0) {
+                            link(topo, i, i + topo->cols - 1);
+                        }
+                    }
+                }
+            }
+            break;
+        case LE_TOPO_TREE:
+            // filled top to bottom, left to right
+            for (uint32_t i = 1; i < n; i++) {
+                link(topo, (i - 1) / 2, i);
+            }
+            break;
+        case LE_TOPO_STAR:
+            for (uint32_t i = 1; i < n; i++) {
+                link(topo, 0, i);
+            }
+            break;
+        case LE_TOPO_COMPLETE:
+            for (uint32_t i = 0; i < n; i++) {
+                for (uint32_t j = i + 1; j < n; j++) {
+                    link(topo, i, j);
+                }
+            }
+            break;
+    }
+}
+
+// Purpose: first pass, degree of every node in offsets[i + 1]
+static void countLink(le_topo_t *topo, uint32_t from, uint32_t to) {
+    topo->offsets[from + 1]++;
+    topo->offsets[to + 1]++;
+}
+
+// Purpose: second pass, offsets[i] is the next free slot of node i
+static void storeLink(le_topo_t *topo, uint32_t from, uint32_t to) {
+    uint8_t both = topo->bidirectional ? (LE_TOPO_IN | LE_TOPO_OUT) : 0;
+    uint32_t e = topo->offsets[from]++;
+    topo->adj[e] = (uint16_t)to;
+    topo->link[e] = LE_TOPO_OUT | both;
+    e = topo->offsets[to]++;
+    topo->adj[e] = (uint16_t)from;
+    topo->link[e] = LE_TOPO_IN | both;
+}
+
+// Purpose: number of links, without generating them
+static uint64_t linksOf(const le_topo_t *topo) {
+    uint64_t n = topo->numNodes, r = topo->rows, c = topo->cols;
+
+    switch (topo->kind) {
+        case LE_TOPO_RING:
+            return (n > 2) ? n : n - 1;
+        case LE_TOPO_GRID:
+            return r * (c - 1) + c * (r - 1);
+        case LE_TOPO_MESH:
+            return r * (c - 1) + c * (r - 1) + 2 * (r - 1) * (c - 1);
+        case LE_TOPO_COMPLETE:
+            return n * (n - 1) / 2;
+        case LE_TOPO_LINE:
+        case LE_TOPO_TREE:
+        case LE_TOPO_STAR:
+            break;
+    }
+    return n - 1;
+}
+
+// Purpose: hop diameter in closed form, along the link directions
+static uint32_t diameterOf(const le_topo_t *topo) {
+    uint32_t n = topo->numNodes;
+    uint32_t depth = 0;
+
+    if (n < 2) {
+        return 0;
+    }
+    switch (topo->kind) {
+        case LE_TOPO_LINE:
+            return n - 1;
+        case LE_TOPO_RING:
+            return (topo->bidirectional && n > 2) ? n / 2 : n - 1;
+        case LE_TOPO_GRID:
+            return (topo->rows - 1) + (topo->cols - 1);
+        case LE_TOPO_MESH:
+            return (topo->rows > topo->cols) ? topo->rows - 1 : topo->cols - 1;
+        case LE_TOPO_STAR:
+            return (topo->bidirectional && n > 2) ? 2 : 1;
+        case LE_TOPO_COMPLETE:
+            return 1;
+        case LE_TOPO_TREE:
+            break;
+    }
+
+    // the last node is the deepest, at depth floor(log2(n))
+    while ((2u << depth) <= n) {
+        depth++;
+    }
+    if (!topo->bidirectional) {
+        return depth;
+    }
+    // the longest path runs from the deepest leaf through the root, into the
+    // right subtree, which reaches the same depth once its half of the last
+    // level has started to fill
+    uint32_t rightHalf = (1u << depth) - 1 + (1u << (depth - 1));
+    return depth + ((n - 1 >= rightHalf) ? depth : depth - 1);
+}
+
+// Purpose: generate a topology into the storage given to le_topo_init
+//
+// topo le_topo_t*, filled in
+// kind le_topo_kind_t, the shape
+// numNodes uint32_t, requested size, grid and mesh use rows x (numNodes / rows)
+// rows uint32_t, grid and mesh rows, 0 for a square-ish layout
+// bidirectional bool, false for links from the lower to the higher index only
+// return 0 on success, -1 if the size does not fit the shape or the storage;
+//    numNodes and numLinks are set in either case, so a caller can size it
+int le_topo_build(le_topo_t *topo, le_topo_kind_t kind, uint32_t numNodes, uint32_t rows, bool bidirectional) {
+    topo->kind = kind;
+    topo->bidirectional = bidirectional;
+    topo->rows = 0;
+    topo->cols = 0;
+    topo->numLinks = 0;
+    topo->diameter = 0;
+
+    if (kind == LE_TOPO_GRID || kind == LE_TOPO_MESH) {
+        if (rows == 0) {
+            while ((rows + 1) * (rows + 1) <= numNodes) {
+                rows++;
+            }
+        }
+        if (rows == 0 || numNodes / rows == 0) {
+            topo->numNodes = 0;
+            return -1;
+        }
+        topo->rows = rows;
+        topo->cols = numNodes / rows;
+        numNodes = topo->rows * topo->cols;
+    }
+    topo->numNodes = numNodes;
+    if (numNodes == 0 || numNodes > UINT16_MAX) {
+        return -1;
+    }
+
+    uint64_t links = 2 * linksOf(topo);
+    if (links > UINT32_MAX) {
+        return -1;
+    }
+    topo->numLinks = (uint32_t)links;
+    if (numNodes > topo->maxNodes || topo->numLinks > topo->maxLinks) {
+        return -1;
+    }
+
+    memset(topo->offsets, 0, (numNodes + 1) * sizeof(uint32_t));
+    forEachLink(topo, countLink);
+    for (uint32_t i = 0; i < numNodes; i++) {
+        topo->offsets[i + 1] += topo->offsets[i];
+    }
+    forEachLink(topo, storeLink);
+    // storing advanced every offset to the start of the next node
+    memmove(topo->offsets + 1, topo->offsets, numNodes * sizeof(uint32_t));
+    topo->offsets[0] = 0;
+
+    topo->diameter = diameterOf(topo);
+    return 0;
+}
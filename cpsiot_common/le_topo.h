@@ -0,0 +1,60 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Topology generator shared by the master node and the simulator.
+ *
+ * Builds the shapes of mac_topology_gen.py (line, ring, grid, mesh, tree,
+ * star, complete) with bidirectional or unidirectional links in compressed
+ * sparse row form. The links of node i are adj[offsets[i] .. offsets[i + 1]),
+ * each tagged with its direction, so a node's whole neighborhood is one slice.
+ * The storage is supplied by the caller, nothing is allocated here.
+ *
+ * Unidirectional links point from the lower to the higher node index, the
+ * ring closes from the last node back to node 0. Only the ring stays
+ * strongly connected that way.
+ */
+
+#ifndef LE_TOPO_H
+#define LE_TOPO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// direction of a link, seen from the node whose slice it is in
+#define LE_TOPO_IN              (0x01)  // the neighbor sends to this node
+#define LE_TOPO_OUT             (0x02)  // this node sends to the neighbor
+
+typedef enum {
+    LE_TOPO_LINE,
+    LE_TOPO_RING,
+    LE_TOPO_GRID,
+    LE_TOPO_MESH,
+    LE_TOPO_TREE,
+    LE_TOPO_STAR,
+    LE_TOPO_COMPLETE,
+} le_topo_kind_t;
+
+typedef struct {
+    le_topo_kind_t kind;
+    bool bidirectional;
+    uint32_t numNodes;
+    uint32_t rows;          // grid and mesh only
+    uint32_t cols;
+    uint32_t numLinks;      // adj entries, two per link
+    uint32_t diameter;      // longest shortest path along the link directions
+
+    // caller storage, see le_topo_init
+    uint32_t *offsets;      // maxNodes + 1 entries
+    uint16_t *adj;          // maxLinks entries, neighbor node index
+    uint8_t *link;          // maxLinks entries, LE_TOPO_IN | LE_TOPO_OUT
+    uint32_t maxNodes;
+    uint32_t maxLinks;
+} le_topo_t;
+
+int le_topo_parse(const char *name, le_topo_kind_t *kind);
+const char *le_topo_name(le_topo_kind_t kind);
+void le_topo_init(le_topo_t *topo, uint32_t *offsets, uint32_t maxNodes,
+                  uint16_t *adj, uint8_t *link, uint32_t maxLinks);
+int le_topo_build(le_topo_t *topo, le_topo_kind_t kind, uint32_t numNodes, uint32_t rows, bool bidirectional);
+
+#endif /* LE_TOPO_H */
@@ -0,0 +1,82 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Trickle timer, see le_trickle.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "le_trickle.h"
+
+// Purpose: begin an interval of the current length, t uniform in [I/2, I)
+//
+// tr le_trickle_t*, the timer
+// rnd uint32_t, a random number
+// return usec until t
+static uint32_t beginInterval(le_trickle_t *tr, uint32_t rnd) {
+    uint32_t half = tr->interval / 2;
+    tr->t = half + ((half > 0) ? rnd % half : 0);
+    tr->c = 0;
+    tr->past = false;
+    return tr->t;
+}
+
+// Purpose: set the parameters, the timer does not run until le_trickle_start
+//
+// tr le_trickle_t*, the timer
+// imin uint32_t, shortest interval, usec
+// imax uint32_t, longest interval, usec, at least imin
+// k uint8_t, redundancy constant, 0 never suppresses
+void le_trickle_init(le_trickle_t *tr, uint32_t imin, uint32_t imax, uint8_t k) {
+    memset(tr, 0, sizeof(*tr));
+    tr->imin = imin;
+    tr->imax = (imax < imin) ? imin : imax;
+    tr->k = k;
+    tr->interval = imin;
+}
+
+// Purpose: start over with the shortest interval
+//
+// return usec until the timer fires
+uint32_t le_trickle_start(le_trickle_t *tr, uint32_t rnd) {
+    tr->interval = tr->imin;
+    return beginInterval(tr, rnd);
+}
+
+// Purpose: a consistent transmission was heard, it counts towards suppression
+void le_trickle_hear(le_trickle_t *tr) {
+    if (tr->c < UINT8_MAX) {
+        tr->c++;
+    }
+}
+
+// Purpose: an inconsistent transmission was heard, or the state changed
+//
+// return usec until the timer fires if the interval starts over, 0 if it
+// already is the shortest one and the armed timer stays
+uint32_t le_trickle_inconsistent(le_trickle_t *tr, uint32_t rnd) {
+    if (tr->interval == tr->imin) {
+        return 0;
+    }
+    return le_trickle_start(tr, rnd);
+}
+
+// Purpose: the timer fired, either at t or at the end of the interval
+//
+// tr le_trickle_t*, the timer
+// rnd uint32_t, a random number
+// transmit bool*, set to whether to transmit now
+// return usec until the timer fires next
+uint32_t le_trickle_expire(le_trickle_t *tr, uint32_t rnd, bool *transmit) {
+    if (!tr->past) {
+        tr->past = true;
+        *transmit = (tr->k == 0 || tr->c < tr->k);
+        return tr->interval - tr->t;
+    }
+    *transmit = false;
+    tr->interval = (tr->interval > tr->imax / 2) ? tr->imax : 2 * tr->interval;
+    return beginInterval(tr, rnd);
+}
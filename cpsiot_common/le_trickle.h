@@ -0,0 +1,37 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Trickle timer (RFC 6206) shared by the worker and the simulator.
+ *
+ * The interval starts at imin and doubles up to imax while everything heard
+ * is consistent. Within each interval a node transmits once, at a random
+ * point in the second half, unless it heard k consistent transmissions
+ * first (k = 0 never suppresses). An inconsistency starts over at imin.
+ * The caller owns the timer and the randomness: every call that returns a
+ * delay wants the timer armed for that long, and le_trickle_expire called
+ * when it fires.
+ */
+
+#ifndef LE_TRICKLE_H
+#define LE_TRICKLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t imin;          // shortest interval, usec
+    uint32_t imax;          // longest interval, usec
+    uint8_t k;              // redundancy constant, 0 never suppresses
+    uint32_t interval;      // current interval, usec
+    uint32_t t;             // transmission point within it
+    uint8_t c;              // consistent transmissions heard in it
+    bool past;              // t has passed, the timer runs to the interval's end
+} le_trickle_t;
+
+void le_trickle_init(le_trickle_t *tr, uint32_t imin, uint32_t imax, uint8_t k);
+uint32_t le_trickle_start(le_trickle_t *tr, uint32_t rnd);
+void le_trickle_hear(le_trickle_t *tr);
+uint32_t le_trickle_inconsistent(le_trickle_t *tr, uint32_t rnd);
+uint32_t le_trickle_expire(le_trickle_t *tr, uint32_t rnd, bool *transmit);
+
+#endif /* LE_TRICKLE_H */
@@ -0,0 +1,599 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Encode and decode the binary frames used between the master and
+ *          worker nodes, see le_wire.h for the layout.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "le_wire.h"
+
+#define IID_LEN                 (8)
+#define ADDR_LEN                (16)
+#define STATS_LEN               (4 * LE_WIRE_CLASSES + 14)  // traffic counters that end a results report
+
+// a full ips frame must fit either way
+#if LE_WIRE_IPS_FIT(IID_LEN) < LE_WIRE_IPS_MAX
+#error "LE_WIRE_IPS_MAX interface ids do not fit an ips frame of LE_WIRE_MAX_LEN"
+#endif
+#if LE_WIRE_IPS_FULL < 1 || LE_WIRE_IPS_FULL > LE_WIRE_IPS_MAX
+#error "LE_WIRE_IPS_FULL full addresses must fit an ips frame of LE_WIRE_MAX_LEN"
+#endif
+
+// Purpose: check if an address can be sent as its 8 byte interface id
+//
+// addr ipv6_addr_t*, the address to check
+static bool isCompact(const ipv6_addr_t *addr) {
+    static const uint8_t prefix[IID_LEN] = { 0xfe, 0x80, 0, 0, 0, 0, 0, 0 };
+    return memcmp(addr->u8, prefix, IID_LEN) == 0;
+}
+
+// Purpose: whether an address goes out as its interface id, an ips frame with
+// only such addresses carries LE_WIRE_IPS_MAX neighbors, otherwise LE_WIRE_IPS_FULL
+//
+// addr ipv6_addr_t*, the address to check
+bool le_wire_compact(const ipv6_addr_t *addr) {
+    return isCompact(addr);
+}
+
+// Purpose: write the 3 byte frame header
+static uint8_t *putHdr(uint8_t *p, uint8_t type, uint8_t flags) {
+    p[0] = LE_WIRE_VERSION;
+    p[1] = type;
+    p[2] = flags;
+    return p + LE_WIRE_HDR_LEN;
+}
+
+static uint8_t *putU16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+    return p + 2;
+}
+
+static uint8_t *putU32(uint8_t *p, uint32_t v) {
+    p = putU16(p, (uint16_t)(v >> 16));
+    return putU16(p, (uint16_t)v);
+}
+
+static uint8_t *putAddr(uint8_t *p, const ipv6_addr_t *addr, bool compact) {
+    if (compact) {
+        memcpy(p, &addr->u8[IID_LEN], IID_LEN);
+        return p + IID_LEN;
+    }
+    memcpy(p, addr->u8, ADDR_LEN);
+    return p + ADDR_LEN;
+}
+
+static const uint8_t *getU16(const uint8_t *p, uint16_t *v) {
+    *v = (uint16_t)((p[0] << 8) | p[1]);
+    return p + 2;
+}
+
+static const uint8_t *getU32(const uint8_t *p, uint32_t *v) {
+    uint16_t hi, lo;
+    p = getU16(p, &hi);
+    p = getU16(p, &lo);
+    *v = ((uint32_t)hi << 16) | lo;
+    return p;
+}
+
+static const uint8_t *getAddr(const uint8_t *p, ipv6_addr_t *addr, bool compact) {
+    if (compact) {
+        memset(addr->u8, 0, IID_LEN);
+        addr->u8[0] = 0xfe;
+        addr->u8[1] = 0x80;
+        memcpy(&addr->u8[IID_LEN], p, IID_LEN);
+        return p + IID_LEN;
+    }
+    memcpy(addr->u8, p, ADDR_LEN);
+    return p + ADDR_LEN;
+}
+
+// Purpose: validate the header of an incoming frame of an expected type
+//
+// return the header flags, or -1 if the frame is not of that type
+static int checkHdr(const uint8_t *buf, size_t len, uint8_t type) {
+    if (le_wire_type(buf, len) != type) {
+        return -1;
+    }
+    return buf[2];
+}
+
+// Purpose: identify an incoming frame
+//
+// buf uint8_t*, the received bytes
+// len size_t, number of received bytes
+// return the message type, or -1 if this is not a frame of our version
+int le_wire_type(const uint8_t *buf, size_t len) {
+    if (buf == NULL || len < LE_WIRE_HDR_LEN || buf[0] != LE_WIRE_VERSION) {
+        return -1;
+    }
+    return buf[1];
+}
+
+// Purpose: traffic class of a message type, for the counters of a results report
+//
+// type int, the message type, e.g. from le_wire_type
+// return one of the LE_WIRE_CLASS_ values
+int le_wire_class(int type) {
+    switch (type) {
+    case LE_WIRE_PING:      return LE_WIRE_CLASS_PING;
+    case LE_WIRE_PONG:      return LE_WIRE_CLASS_PONG;
+    case LE_WIRE_IPS:       return LE_WIRE_CLASS_IPS;
+    case LE_WIRE_START:     return LE_WIRE_CLASS_START;
+    case LE_WIRE_QUERY:     return LE_WIRE_CLASS_QUERY;
+    case LE_WIRE_ACK:       return LE_WIRE_CLASS_ACK;
+    case LE_WIRE_RESULTS:   return LE_WIRE_CLASS_RESULTS;
+    default:                return LE_WIRE_CLASS_OTHER;
+    }
+}
+
+// Purpose: printable name of a message type
+//
+// type int, the message type
+// return the name, "unknown" for a type this version does not have
+const char *le_wire_type_name(int type) {
+    static const char *const names[LE_WIRE_TYPES] = {
+        "unknown", "ping", "pong", "conf", "ips", "start", "le_m?", "le_ack", "results",
+        "rconf", "le_done", "ips_ack", "sync", "reset", "reset_ack", "hb", "hello"
+    };
+    return (type > 0 && type < LE_WIRE_TYPES) ? names[type] : names[0];
+}
+
+// Purpose: printable name of a traffic class
+//
+// cls int, one of the LE_WIRE_CLASS_ values
+const char *le_wire_class_name(int cls) {
+    static const char *const names[LE_WIRE_CLASSES] = {
+        "ping", "pong", "ips", "start", "le_m?", "le_ack", "results", "other"
+    };
+    return (cls >= 0 && cls < LE_WIRE_CLASSES) ? names[cls] : names[LE_WIRE_CLASS_OTHER];
+}
+
+// Purpose: encode a message that consists of the header only (rconf)
+//
+// buf uint8_t*, destination buffer
+// len size_t, size of the destination buffer
+// type uint8_t, the message type
+// return the encoded length, or -1 if the buffer is too small
+int le_wire_encode(uint8_t *buf, size_t len, uint8_t type) {
+    if (len < LE_WIRE_HDR_LEN) {
+        return -1;
+    }
+    putHdr(buf, type, 0);
+    return LE_WIRE_HDR_LEN;
+}
+
+// Purpose: encode a discovery ping, <tx>
+int le_wire_encode_ping(uint8_t *buf, size_t len, const le_wire_ping_t *ping) {
+    if (len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_PING, 0);
+    p = putU32(p, ping->tx);
+    return p - buf;
+}
+
+// Purpose: decode a discovery ping
+int le_wire_decode_ping(const uint8_t *buf, size_t len, le_wire_ping_t *ping) {
+    if (checkHdr(buf, len, LE_WIRE_PING) < 0 || len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    getU32(buf + LE_WIRE_HDR_LEN, &ping->tx);
+    return 0;
+}
+
+// Purpose: encode the answer to a ping, <pingTx><rx><tx>
+int le_wire_encode_pong(uint8_t *buf, size_t len, const le_wire_pong_t *pong) {
+    if (len < LE_WIRE_HDR_LEN + 12) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_PONG, 0);
+    p = putU32(p, pong->pingTx);
+    p = putU32(p, pong->rx);
+    p = putU32(p, pong->tx);
+    return p - buf;
+}
+
+// Purpose: decode the answer to a ping
+int le_wire_decode_pong(const uint8_t *buf, size_t len, le_wire_pong_t *pong) {
+    if (checkHdr(buf, len, LE_WIRE_PONG) < 0 || len < LE_WIRE_HDR_LEN + 12) {
+        return -1;
+    }
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU32(p, &pong->pingTx);
+    p = getU32(p, &pong->rx);
+    getU32(p, &pong->tx);
+    return 0;
+}
+
+// Purpose: encode the confirmation of a discovered worker, <offset>
+int le_wire_encode_conf(uint8_t *buf, size_t len, const le_wire_conf_t *conf) {
+    if (len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_CONF, 0);
+    p = putU32(p, conf->offset);
+    return p - buf;
+}
+
+// Purpose: decode the confirmation of a discovered worker
+int le_wire_decode_conf(const uint8_t *buf, size_t len, le_wire_conf_t *conf) {
+    if (checkHdr(buf, len, LE_WIRE_CONF) < 0 || len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    getU32(buf + LE_WIRE_HDR_LEN, &conf->offset);
+    return 0;
+}
+
+// Purpose: encode a clock beacon, <tx>
+int le_wire_encode_sync(uint8_t *buf, size_t len, const le_wire_sync_t *sync) {
+    if (len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_SYNC, 0);
+    p = putU32(p, sync->tx);
+    return p - buf;
+}
+
+// Purpose: decode a clock beacon
+int le_wire_decode_sync(const uint8_t *buf, size_t len, le_wire_sync_t *sync) {
+    if (checkHdr(buf, len, LE_WIRE_SYNC) < 0 || len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    getU32(buf + LE_WIRE_HDR_LEN, &sync->tx);
+    return 0;
+}
+
+// Purpose: encode a reset, <epoch><m>, or its confirmation, <epoch>
+//
+// type uint8_t, LE_WIRE_RESET or LE_WIRE_RESET_ACK
+int le_wire_encode_reset(uint8_t *buf, size_t len, uint8_t type, const le_wire_reset_t *reset) {
+    size_t need = LE_WIRE_HDR_LEN + ((type == LE_WIRE_RESET) ? 4 : 2);
+    if (len < need) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, type, 0);
+    p = putU16(p, reset->epoch);
+    if (type == LE_WIRE_RESET) {
+        p = putU16(p, reset->m);
+    }
+    return p - buf;
+}
+
+// Purpose: decode a reset or its confirmation, m is 0 for the latter
+int le_wire_decode_reset(const uint8_t *buf, size_t len, uint8_t type, le_wire_reset_t *reset) {
+    size_t need = LE_WIRE_HDR_LEN + ((type == LE_WIRE_RESET) ? 4 : 2);
+    if (checkHdr(buf, len, type) < 0 || len < need) {
+        return -1;
+    }
+    const uint8_t *p = getU16(buf + LE_WIRE_HDR_LEN, &reset->epoch);
+    reset->m = 0;
+    if (type == LE_WIRE_RESET) {
+        getU16(p, &reset->m);
+    }
+    return 0;
+}
+
+// Purpose: encode the start of an election run, <epoch><startAt>
+int le_wire_encode_start(uint8_t *buf, size_t len, const le_wire_start_t *start) {
+    if (len < LE_WIRE_HDR_LEN + 6) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_START, 0);
+    p = putU16(p, start->epoch);
+    p = putU32(p, start->startAt);
+    return p - buf;
+}
+
+// Purpose: decode the start of an election run
+int le_wire_decode_start(const uint8_t *buf, size_t len, le_wire_start_t *start) {
+    if (checkHdr(buf, len, LE_WIRE_START) < 0 || len < LE_WIRE_HDR_LEN + 6) {
+        return -1;
+    }
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU16(p, &start->epoch);
+    getU32(p, &start->startAt);
+    return 0;
+}
+
+// Purpose: encode an le_m? query, <epoch><round>
+int le_wire_encode_query(uint8_t *buf, size_t len, const le_wire_query_t *query) {
+    if (len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_QUERY, 0);
+    p = putU16(p, query->epoch);
+    p = putU16(p, query->round);
+    return p - buf;
+}
+
+// Purpose: decode an le_m? query
+//
+// return 0 on success, -1 if the frame is malformed
+int le_wire_decode_query(const uint8_t *buf, size_t len, le_wire_query_t *query) {
+    if (checkHdr(buf, len, LE_WIRE_QUERY) < 0 || len < LE_WIRE_HDR_LEN + 4) {
+        return -1;
+    }
+    const uint8_t *p = getU16(buf + LE_WIRE_HDR_LEN, &query->epoch);
+    getU16(p, &query->round);
+    return 0;
+}
+
+// Purpose: encode an le_ack, <epoch><term><round><m><hops><span><quiet><leader><sender>
+int le_wire_encode_ack(uint8_t *buf, size_t len, const le_wire_ack_t *ack) {
+    bool compact = isCompact(&ack->leader) && isCompact(&ack->sender);
+    size_t need = LE_WIRE_HDR_LEN + 10 + 2 * (compact ? IID_LEN : ADDR_LEN);
+
+    if (len < need) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_ACK, compact ? LE_WIRE_FLAG_IID : 0);
+    p = putU16(p, ack->epoch);
+    *p++ = ack->term;
+    p = putU16(p, ack->round);
+    p = putU16(p, ack->m);
+    *p++ = ack->hops;
+    *p++ = ack->span;
+    *p++ = ack->quiet;
+    p = putAddr(p, &ack->leader, compact);
+    p = putAddr(p, &ack->sender, compact);
+    return p - buf;
+}
+
+// Purpose: decode an le_ack
+int le_wire_decode_ack(const uint8_t *buf, size_t len, le_wire_ack_t *ack) {
+    int flags = checkHdr(buf, len, LE_WIRE_ACK);
+    if (flags < 0) {
+        return -1;
+    }
+    bool compact = (flags & LE_WIRE_FLAG_IID);
+    if (len < LE_WIRE_HDR_LEN + 10 + 2 * (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU16(p, &ack->epoch);
+    ack->term = *p++;
+    p = getU16(p, &ack->round);
+    p = getU16(p, &ack->m);
+    ack->hops = *p++;
+    ack->span = *p++;
+    ack->quiet = *p++;
+    p = getAddr(p, &ack->leader, compact);
+    getAddr(p, &ack->sender, compact);
+    return 0;
+}
+
+// Purpose: encode the topology assignment, <m><diameter><part><count>[<in><out>]<self><neighbor>...
+// nodes with more neighbors than one frame carries (LE_WIRE_IPS_MAX, or
+// LE_WIRE_IPS_FULL with full addresses) get several frames, all but the last
+// one flagged LE_WIRE_FLAG_MORE; the direction masks are only sent if some
+// link is not bidirectional
+int le_wire_encode_ips(uint8_t *buf, size_t len, const le_wire_ips_t *ips) {
+    bool compact = isCompact(&ips->self);
+    uint8_t i;
+
+    if (ips->numNeighbors > LE_WIRE_IPS_MAX) {
+        return -1;
+    }
+    for (i = 0; i < ips->numNeighbors; i++) {
+        compact = compact && isCompact(&ips->neighbors[i]);
+    }
+    uint8_t all = (uint8_t)((1u << ips->numNeighbors) - 1);
+    bool directed = ((ips->linksIn & all) != all) || ((ips->linksOut & all) != all);
+    size_t need = LE_WIRE_HDR_LEN + 5 + (directed ? 2 : 0) + (1 + ips->numNeighbors) * (compact ? IID_LEN : ADDR_LEN);
+    if (len < need) {
+        return -1;
+    }
+
+    uint8_t flags = (compact ? LE_WIRE_FLAG_IID : 0) | (ips->more ? LE_WIRE_FLAG_MORE : 0) |
+                    (directed ? LE_WIRE_FLAG_DIR : 0);
+    uint8_t *p = putHdr(buf, LE_WIRE_IPS, flags);
+    p = putU16(p, ips->m);
+    *p++ = ips->diameter;
+    *p++ = ips->part;
+    *p++ = ips->numNeighbors;
+    if (directed) {
+        *p++ = ips->linksIn & all;
+        *p++ = ips->linksOut & all;
+    }
+    p = putAddr(p, &ips->self, compact);
+    for (i = 0; i < ips->numNeighbors; i++) {
+        p = putAddr(p, &ips->neighbors[i], compact);
+    }
+    return p - buf;
+}
+
+// Purpose: decode the topology assignment
+int le_wire_decode_ips(const uint8_t *buf, size_t len, le_wire_ips_t *ips) {
+    int flags = checkHdr(buf, len, LE_WIRE_IPS);
+    if (flags < 0 || len < LE_WIRE_HDR_LEN + 5) {
+        return -1;
+    }
+    bool compact = (flags & LE_WIRE_FLAG_IID);
+    bool directed = (flags & LE_WIRE_FLAG_DIR);
+    ips->more = (flags & LE_WIRE_FLAG_MORE);
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU16(p, &ips->m);
+    ips->diameter = *p++;
+    ips->part = *p++;
+    ips->numNeighbors = *p++;
+    if (ips->numNeighbors > LE_WIRE_IPS_MAX ||
+        len < (size_t)(LE_WIRE_HDR_LEN + 5 + (directed ? 2 : 0) +
+                       (1 + ips->numNeighbors) * (compact ? IID_LEN : ADDR_LEN))) {
+        return -1;
+    }
+    // without masks every link is bidirectional
+    ips->linksIn = (uint8_t)((1u << ips->numNeighbors) - 1);
+    ips->linksOut = ips->linksIn;
+    if (directed) {
+        ips->linksIn &= *p++;
+        ips->linksOut &= *p++;
+    }
+    p = getAddr(p, &ips->self, compact);
+    for (uint8_t i = 0; i < ips->numNeighbors; i++) {
+        p = getAddr(p, &ips->neighbors[i], compact);
+    }
+    return 0;
+}
+
+// Purpose: encode the confirmation of an ips frame, <part>
+int le_wire_encode_ips_ack(uint8_t *buf, size_t len, const le_wire_ips_ack_t *ack) {
+    if (len < LE_WIRE_HDR_LEN + 1) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_IPS_ACK, 0);
+    *p++ = ack->part;
+    return p - buf;
+}
+
+// Purpose: decode the confirmation of an ips frame
+int le_wire_decode_ips_ack(const uint8_t *buf, size_t len, le_wire_ips_ack_t *ack) {
+    if (checkHdr(buf, len, LE_WIRE_IPS_ACK) < 0 || len < LE_WIRE_HDR_LEN + 1) {
+        return -1;
+    }
+    ack->part = buf[LE_WIRE_HDR_LEN];
+    return 0;
+}
+
+// Purpose: encode the election results,
+// <epoch><m><leader><convergence><messages><rounds><started><ended><term><failover><stats>
+// with <stats> = <rx per class><tx per class><rxBytes><txBytes><sendFail><ipcDrop><parseErr>
+int le_wire_encode_results(uint8_t *buf, size_t len, const le_wire_results_t *results) {
+    bool compact = isCompact(&results->leader);
+    if (len < LE_WIRE_HDR_LEN + 27 + STATS_LEN + (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_RESULTS, compact ? LE_WIRE_FLAG_IID : 0);
+    p = putU16(p, results->epoch);
+    p = putU16(p, results->m);
+    p = putAddr(p, &results->leader, compact);
+    p = putU32(p, results->convergence);
+    p = putU32(p, results->messages);
+    p = putU16(p, results->rounds);
+    p = putU32(p, results->started);
+    p = putU32(p, results->ended);
+    *p++ = results->term;
+    p = putU32(p, results->failover);
+
+    const le_wire_stats_t *stats = &results->stats;
+    for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+        p = putU16(p, stats->rx[i]);
+    }
+    for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+        p = putU16(p, stats->tx[i]);
+    }
+    p = putU32(p, stats->rxBytes);
+    p = putU32(p, stats->txBytes);
+    p = putU16(p, stats->sendFail);
+    p = putU16(p, stats->ipcDrop);
+    p = putU16(p, stats->parseErr);
+    return p - buf;
+}
+
+// Purpose: decode the election results
+int le_wire_decode_results(const uint8_t *buf, size_t len, le_wire_results_t *results) {
+    int flags = checkHdr(buf, len, LE_WIRE_RESULTS);
+    if (flags < 0) {
+        return -1;
+    }
+    bool compact = (flags & LE_WIRE_FLAG_IID);
+    if (len < LE_WIRE_HDR_LEN + 27 + STATS_LEN + (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU16(p, &results->epoch);
+    p = getU16(p, &results->m);
+    p = getAddr(p, &results->leader, compact);
+    p = getU32(p, &results->convergence);
+    p = getU32(p, &results->messages);
+    p = getU16(p, &results->rounds);
+    p = getU32(p, &results->started);
+    p = getU32(p, &results->ended);
+    results->term = *p++;
+    p = getU32(p, &results->failover);
+
+    le_wire_stats_t *stats = &results->stats;
+    for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+        p = getU16(p, &stats->rx[i]);
+    }
+    for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+        p = getU16(p, &stats->tx[i]);
+    }
+    p = getU32(p, &stats->rxBytes);
+    p = getU32(p, &stats->txBytes);
+    p = getU16(p, &stats->sendFail);
+    p = getU16(p, &stats->ipcDrop);
+    getU16(p, &stats->parseErr);
+    return 0;
+}
+
+// Purpose: encode an le_done, <epoch><term><m><leader>
+int le_wire_encode_done(uint8_t *buf, size_t len, const le_wire_done_t *done) {
+    bool compact = isCompact(&done->leader);
+    if (len < LE_WIRE_HDR_LEN + 5 + (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_DONE, compact ? LE_WIRE_FLAG_IID : 0);
+    p = putU16(p, done->epoch);
+    *p++ = done->term;
+    p = putU16(p, done->m);
+    p = putAddr(p, &done->leader, compact);
+    return p - buf;
+}
+
+// Purpose: decode an le_done
+int le_wire_decode_done(const uint8_t *buf, size_t len, le_wire_done_t *done) {
+    int flags = checkHdr(buf, len, LE_WIRE_DONE);
+    if (flags < 0) {
+        return -1;
+    }
+    bool compact = (flags & LE_WIRE_FLAG_IID);
+    if (len < LE_WIRE_HDR_LEN + 5 + (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU16(p, &done->epoch);
+    done->term = *p++;
+    p = getU16(p, &done->m);
+    getAddr(p, &done->leader, compact);
+    return 0;
+}
+
+// Purpose: encode a leader heartbeat, <epoch><term><seq><m><leader>
+int le_wire_encode_hb(uint8_t *buf, size_t len, const le_wire_hb_t *hb) {
+    bool compact = isCompact(&hb->leader);
+    if (len < LE_WIRE_HDR_LEN + 7 + (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    uint8_t *p = putHdr(buf, LE_WIRE_HB, compact ? LE_WIRE_FLAG_IID : 0);
+    p = putU16(p, hb->epoch);
+    *p++ = hb->term;
+    p = putU16(p, hb->seq);
+    p = putU16(p, hb->m);
+    p = putAddr(p, &hb->leader, compact);
+    return p - buf;
+}
+
+// Purpose: decode a leader heartbeat
+int le_wire_decode_hb(const uint8_t *buf, size_t len, le_wire_hb_t *hb) {
+    int flags = checkHdr(buf, len, LE_WIRE_HB);
+    if (flags < 0) {
+        return -1;
+    }
+    bool compact = (flags & LE_WIRE_FLAG_IID);
+    if (len < LE_WIRE_HDR_LEN + 7 + (compact ? IID_LEN : ADDR_LEN)) {
+        return -1;
+    }
+    const uint8_t *p = buf + LE_WIRE_HDR_LEN;
+    p = getU16(p, &hb->epoch);
+    hb->term = *p++;
+    p = getU16(p, &hb->seq);
+    p = getU16(p, &hb->m);
+    getAddr(p, &hb->leader, compact);
+    return 0;
+}
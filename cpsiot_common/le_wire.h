@@ -0,0 +1,218 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Compact binary wire format shared by the master and worker nodes.
+ *
+ * Every frame starts with a 3 byte header: version, message type and flags.
+ * Multi-byte fields are big endian. Node identifiers are raw IPv6 addresses,
+ * shortened to their 8 byte interface identifier when every address in the
+ * frame is link-local (fe80::/64), which keeps an le_ack at 29 bytes.
+ *
+ * Every election message carries the epoch of the run, taken from the
+ * master's start message, and le_m?/le_ack also carry the round number.
+ * le_ack, le_done and heartbeats carry the term, the number of times the
+ * nodes re-elected after losing the leader within the run. An le_ack also
+ * announces how many of the following rounds its sender will stay quiet.
+ * The results report ends with the worker's traffic counters by class,
+ * which makes it the largest frame at 84 bytes.
+ */
+
+#ifndef LE_WIRE_H
+#define LE_WIRE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/ipv6/addr.h"
+
+#define LE_WIRE_VERSION         (11)
+#define LE_WIRE_HDR_LEN         (3)
+#define LE_WIRE_MAX_LEN         (128)
+
+// message types, byte 1 of the header
+#define LE_WIRE_PING            (0x01)  // master discovery multicast
+#define LE_WIRE_PONG            (0x02)  // worker answer to a ping
+#define LE_WIRE_CONF            (0x03)  // master confirms a discovered worker
+#define LE_WIRE_IPS             (0x04)  // m value, own address and neighbors
+#define LE_WIRE_START           (0x05)  // begin leader election
+#define LE_WIRE_QUERY           (0x06)  // le_m?, ask neighbors for their m
+#define LE_WIRE_ACK             (0x07)  // le_ack, a node's current min and leader
+#define LE_WIRE_RESULTS         (0x08)  // election outcome reported to the master
+#define LE_WIRE_RCONF           (0x09)  // master confirms the results
+#define LE_WIRE_DONE            (0x0A)  // le_done, flooded once by every node that finished
+#define LE_WIRE_IPS_ACK         (0x0B)  // worker confirms one ips frame
+#define LE_WIRE_SYNC            (0x0C)  // master clock beacon
+#define LE_WIRE_RESET           (0x0D)  // master prepares a worker for another run
+#define LE_WIRE_RESET_ACK       (0x0E)  // worker confirms the reset
+#define LE_WIRE_HB              (0x0F)  // leader heartbeat, flooded after the election
+#define LE_WIRE_HELLO           (0x10)  // link-local neighbor discovery, header only
+#define LE_WIRE_TYPES           (0x11)  // one past the last type, for tables indexed by type
+
+// header flags, byte 2 of the header
+#define LE_WIRE_FLAG_IID        (0x01)  // addresses are fe80::/64 interface ids
+#define LE_WIRE_FLAG_MORE       (0x02)  // ips: further neighbors follow in another frame
+#define LE_WIRE_FLAG_DIR        (0x04)  // ips: link direction masks follow the count
+
+// neighbors carried by one ips frame: up to LE_WIRE_IPS_MAX (one bit each in
+// the direction masks) as long as every address is an fe80::/64 interface id,
+// LE_WIRE_IPS_FULL once any address goes out in full; the frame up to the own
+// address is LE_WIRE_IPS_HDR_LEN long, masks included
+#define LE_WIRE_IPS_MAX         (8)
+#define LE_WIRE_IPS_HDR_LEN     (LE_WIRE_HDR_LEN + 7)
+#define LE_WIRE_IPS_FIT(addrLen) ((LE_WIRE_MAX_LEN - LE_WIRE_IPS_HDR_LEN) / (addrLen) - 1)
+#define LE_WIRE_IPS_FULL        (LE_WIRE_IPS_FIT(16))
+
+// traffic classes of the counters in a results report, the election's own
+// messages each get one and everything else shares the last
+#define LE_WIRE_CLASS_PING      (0)
+#define LE_WIRE_CLASS_PONG      (1)
+#define LE_WIRE_CLASS_IPS       (2)
+#define LE_WIRE_CLASS_START     (3)
+#define LE_WIRE_CLASS_QUERY     (4)
+#define LE_WIRE_CLASS_ACK       (5)
+#define LE_WIRE_CLASS_RESULTS   (6)
+#define LE_WIRE_CLASS_OTHER     (7)
+#define LE_WIRE_CLASSES         (8)
+
+// discovery doubles as a clock offset measurement, ping and pong carry the
+// four timestamps of an NTP exchange, each in its sender's xtimer clock
+typedef struct {
+    uint32_t tx;            // master clock when the ping was sent
+} le_wire_ping_t;
+
+typedef struct {
+    uint32_t pingTx;        // tx of the ping being answered
+    uint32_t rx;            // worker clock when that ping arrived
+    uint32_t tx;            // worker clock when the pong was sent
+} le_wire_pong_t;
+
+typedef struct {
+    uint32_t offset;        // worker clock minus master clock, modulo 2^32
+} le_wire_conf_t;
+
+typedef struct {
+    uint16_t epoch;
+    uint32_t startAt;       // master clock at which every node starts
+} le_wire_start_t;
+
+typedef struct {
+    uint32_t tx;            // master clock when the beacon was sent
+} le_wire_sync_t;
+
+// a reset keeps the topology, the worker forgets its election and takes a
+// new m; the ack echoes the epoch
+typedef struct {
+    uint16_t epoch;         // run the reset prepares for
+    uint16_t m;
+} le_wire_reset_t;
+
+typedef struct {
+    uint16_t epoch;
+    uint16_t round;
+} le_wire_query_t;
+
+typedef struct {
+    uint16_t epoch;
+    uint8_t term;
+    uint16_t round;
+    uint16_t m;
+    uint8_t hops;           // sender's distance to leader
+    uint8_t span;           // largest leader distance the sender has heard of
+    uint8_t quiet;          // rounds after this one the sender skips unless its view changes
+    ipv6_addr_t leader;
+    ipv6_addr_t sender;
+} le_wire_ack_t;
+
+typedef struct {
+    uint16_t m;
+    uint8_t diameter;       // network diameter in hops, 0 if the master does not know it
+    uint8_t part;           // index of this frame among the node's ips frames
+    ipv6_addr_t self;
+    bool more;              // not the last ips frame for this node
+    uint8_t numNeighbors;
+    uint8_t linksIn;        // bit i set: neighbors[i] sends to this node
+    uint8_t linksOut;       // bit i set: this node sends to neighbors[i]
+    ipv6_addr_t neighbors[LE_WIRE_IPS_MAX];
+} le_wire_ips_t;
+
+typedef struct {
+    uint8_t part;           // the ips frame being confirmed
+} le_wire_ips_ack_t;
+
+// a worker's traffic since its counters were last reset, frame counts
+// saturate at 65535; bytes are totals, the frames of a class are of about
+// the same size
+typedef struct {
+    uint16_t rx[LE_WIRE_CLASSES];   // frames received per class
+    uint16_t tx[LE_WIRE_CLASSES];   // frames sent per class
+    uint32_t rxBytes;
+    uint32_t txBytes;
+    uint16_t sendFail;      // frames sock_udp_send refused
+    uint16_t ipcDrop;       // events lost to a full message queue or event pool
+    uint16_t parseErr;      // frames that did not decode
+} le_wire_stats_t;
+
+typedef struct {
+    uint16_t epoch;         // run the results belong to
+    uint16_t m;
+    ipv6_addr_t leader;
+    uint32_t convergence;
+    uint32_t messages;
+    uint16_t rounds;        // election rounds the node needed
+    uint32_t started;       // election start and end, in the master's clock
+    uint32_t ended;
+    uint8_t term;           // 0 for the election the master started
+    uint32_t failover;      // re-elections: last heartbeat of the dead leader to the new one, usec
+    le_wire_stats_t stats;
+} le_wire_results_t;
+
+typedef struct {
+    uint16_t epoch;
+    uint8_t term;
+    uint16_t m;
+    ipv6_addr_t leader;
+} le_wire_done_t;
+
+typedef struct {
+    uint16_t epoch;
+    uint8_t term;
+    uint16_t seq;           // advanced by the leader every heartbeat period
+    uint16_t m;             // the leader's m
+    ipv6_addr_t leader;
+} le_wire_hb_t;
+
+bool le_wire_compact(const ipv6_addr_t *addr);
+int le_wire_type(const uint8_t *buf, size_t len);
+int le_wire_class(int type);
+const char *le_wire_type_name(int type);
+const char *le_wire_class_name(int cls);
+int le_wire_encode(uint8_t *buf, size_t len, uint8_t type);
+int le_wire_encode_ping(uint8_t *buf, size_t len, const le_wire_ping_t *ping);
+int le_wire_decode_ping(const uint8_t *buf, size_t len, le_wire_ping_t *ping);
+int le_wire_encode_pong(uint8_t *buf, size_t len, const le_wire_pong_t *pong);
+int le_wire_decode_pong(const uint8_t *buf, size_t len, le_wire_pong_t *pong);
+int le_wire_encode_conf(uint8_t *buf, size_t len, const le_wire_conf_t *conf);
+int le_wire_decode_conf(const uint8_t *buf, size_t len, le_wire_conf_t *conf);
+int le_wire_encode_sync(uint8_t *buf, size_t len, const le_wire_sync_t *sync);
+int le_wire_decode_sync(const uint8_t *buf, size_t len, le_wire_sync_t *sync);
+int le_wire_encode_reset(uint8_t *buf, size_t len, uint8_t type, const le_wire_reset_t *reset);
+int le_wire_decode_reset(const uint8_t *buf, size_t len, uint8_t type, le_wire_reset_t *reset);
+int le_wire_encode_start(uint8_t *buf, size_t len, const le_wire_start_t *start);
+int le_wire_decode_start(const uint8_t *buf, size_t len, le_wire_start_t *start);
+int le_wire_encode_query(uint8_t *buf, size_t len, const le_wire_query_t *query);
+int le_wire_decode_query(const uint8_t *buf, size_t len, le_wire_query_t *query);
+int le_wire_encode_ack(uint8_t *buf, size_t len, const le_wire_ack_t *ack);
+int le_wire_decode_ack(const uint8_t *buf, size_t len, le_wire_ack_t *ack);
+int le_wire_encode_ips(uint8_t *buf, size_t len, const le_wire_ips_t *ips);
+int le_wire_decode_ips(const uint8_t *buf, size_t len, le_wire_ips_t *ips);
+int le_wire_encode_ips_ack(uint8_t *buf, size_t len, const le_wire_ips_ack_t *ack);
+int le_wire_decode_ips_ack(const uint8_t *buf, size_t len, le_wire_ips_ack_t *ack);
+int le_wire_encode_results(uint8_t *buf, size_t len, const le_wire_results_t *results);
+int le_wire_decode_results(const uint8_t *buf, size_t len, le_wire_results_t *results);
+int le_wire_encode_done(uint8_t *buf, size_t len, const le_wire_done_t *done);
+int le_wire_decode_done(const uint8_t *buf, size_t len, le_wire_done_t *done);
+int le_wire_encode_hb(uint8_t *buf, size_t len, const le_wire_hb_t *hb);
+int le_wire_decode_hb(const uint8_t *buf, size_t len, le_wire_hb_t *hb);
+
+#endif /* LE_WIRE_H */
@@ -0,0 +1,76 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Hashed node registry of the master, see registry.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "registry.h"
+
+// Purpose: FNV-1a over the address, reduced to a home slot
+//
+// addr ipv6_addr_t*, the address to hash
+static unsigned homeSlot(const ipv6_addr_t *addr) {
+    uint32_t h = 2166136261u;
+    for (unsigned i = 0; i < sizeof(addr->u8); i++) {
+        h = (h ^ addr->u8[i]) * 16777619u;
+    }
+    return h % REG_HASH_SIZE;
+}
+
+// Purpose: empty the registry
+//
+// reg reg_table_t*, the registry to reset
+void reg_init(reg_table_t *reg) {
+    memset(reg, 0, sizeof(*reg));
+}
+
+// Purpose: look up a node by address
+//
+// return the node index, or -1 if it was not discovered
+int reg_find(const reg_table_t *reg, const ipv6_addr_t *addr) {
+    unsigned s = homeSlot(addr);
+    while (reg->slots[s] != 0) {
+        if (ipv6_addr_equal(&reg->nodes[reg->slots[s] - 1].addr, addr)) {
+            return reg->slots[s] - 1;
+        }
+        s = (s + 1) % REG_HASH_SIZE;
+    }
+    return -1;
+}
+
+// Purpose: register a discovered node, nodes are never removed during a run
+//
+// reg reg_table_t*, the registry
+// addr ipv6_addr_t*, the node's address
+// added bool*, set to whether the node is new
+// return the node index (also if already present), or -1 if the registry is
+//    full, the node is then counted in rejected
+int reg_add(reg_table_t *reg, const ipv6_addr_t *addr, bool *added) {
+    int idx = reg_find(reg, addr);
+    *added = false;
+    if (idx >= 0) {
+        return idx;
+    }
+    if (reg->count >= LE_MAX_NODES) {
+        reg->rejected++;
+        return -1;
+    }
+
+    idx = reg->count++;
+    reg_node_t *node = &reg->nodes[idx];
+    memset(node, 0, sizeof(*node));
+    node->addr = *addr;
+
+    unsigned slot = homeSlot(addr);
+    while (reg->slots[slot] != 0) {
+        slot = (slot + 1) % REG_HASH_SIZE;
+    }
+    reg->slots[slot] = idx + 1;
+    *added = true;
+    return idx;
+}
@@ -0,0 +1,48 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Registry of the worker nodes the master has discovered.
+ *
+ * Nodes are kept dense in nodes[0..count) in discovery order, which is also
+ * their index in the generated topology. An open addressing hash index on the
+ * binary address finds a node in O(1) for every pong and results frame. The
+ * capacity comes from the Makefile (LE_MAX_NODES); once it is reached further
+ * nodes are turned away and only counted.
+ */
+
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "net/ipv6/addr.h"
+
+#ifndef LE_MAX_NODES
+#define LE_MAX_NODES            (256)
+#endif
+
+// hash index slots, kept at most half full so probe chains stay short
+#define REG_HASH_SIZE           (2 * LE_MAX_NODES + 1)
+
+typedef struct {
+    ipv6_addr_t addr;
+    uint16_t m;             // m value assigned at discovery
+    uint32_t offset;        // node clock minus master clock, modulo 2^32
+    uint32_t rtt;           // round trip of the pong the offset came from
+    bool running;           // takes part in the current run
+    bool reported;          // results received for the current run
+} reg_node_t;
+
+typedef struct {
+    reg_node_t nodes[LE_MAX_NODES];
+    uint16_t slots[REG_HASH_SIZE];  // node index + 1, 0 marks an empty slot
+    uint16_t count;
+    uint32_t rejected;              // pongs from new nodes while the registry was full
+} reg_table_t;
+
+void reg_init(reg_table_t *reg);
+int reg_add(reg_table_t *reg, const ipv6_addr_t *addr, bool *added);
+int reg_find(const reg_table_t *reg, const ipv6_addr_t *addr);
+
+#endif /* REGISTRY_H */
@@ -0,0 +1,148 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Results table of the master, see results.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "results.h"
+
+// convergence or failover values of the run being aggregated, sorted in place
+static uint32_t scratch[LE_MAX_RESULTS];
+
+// Purpose: order for qsort, ascending
+static int compareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Purpose: empty the table
+//
+// table res_table_t*, the table to reset
+void res_init(res_table_t *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+// Purpose: append a row, overwriting the oldest one if the table is full
+//
+// table res_table_t*, the table
+// return the row to fill in
+res_row_t *res_add(res_table_t *table) {
+    unsigned i = (table->head + table->count) % LE_MAX_RESULTS;
+    if (table->count < LE_MAX_RESULTS) {
+        table->count++;
+    } else {
+        table->head = (table->head + 1) % LE_MAX_RESULTS;
+        table->overwritten++;
+    }
+    memset(&table->rows[i], 0, sizeof(table->rows[i]));
+    return &table->rows[i];
+}
+
+// Purpose: the i-th oldest row
+//
+// return the row, or NULL if i is past the last one
+const res_row_t *res_get(const res_table_t *table, unsigned i) {
+    if (i >= table->count) {
+        return NULL;
+    }
+    return &table->rows[(table->head + i) % LE_MAX_RESULTS];
+}
+
+// Purpose: aggregate the rows of one run, the election and any re-elections
+// after a leader failure
+//
+// table res_table_t*, the table
+// run uint16_t, the epoch to aggregate
+// stats res_stats_t*, filled in, all zero if the run has no rows
+// return the number of term 0 rows of the run
+int res_stats(const res_table_t *table, uint16_t run, res_stats_t *stats) {
+    uint32_t firstStart = 0, lastEnd = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->agreed = true;
+    for (unsigned i = 0; i < table->count; i++) {
+        const res_row_t *row = res_get(table, i);
+        if (row->run != run || row->term != 0) {
+            continue;
+        }
+        if (stats->reported == 0) {
+            stats->leader = row->leader;
+            firstStart = row->started;
+            lastEnd = row->ended;
+        }
+        if (row->leader != stats->leader || row->leader == RES_UNKNOWN) {
+            stats->agreed = false;
+        }
+        // timestamps wrap after 71 minutes, compare them as differences
+        if ((int32_t)(row->started - firstStart) < 0) {
+            firstStart = row->started;
+        }
+        if ((int32_t)(row->ended - lastEnd) > 0) {
+            lastEnd = row->ended;
+        }
+        stats->messages += row->messages;
+        scratch[stats->reported++] = row->convergence;
+    }
+    if (stats->reported == 0) {
+        stats->agreed = false;
+        return 0;
+    }
+
+    unsigned n = stats->reported;
+    qsort(scratch, n, sizeof(uint32_t), compareU32);
+    stats->convMin = scratch[0];
+    stats->convMedian = scratch[n / 2];
+    stats->convP95 = scratch[(95 * n + 99) / 100 - 1]; // nearest rank
+    stats->convMax = scratch[n - 1];
+    stats->network = lastEnd - firstStart;
+
+    // the failovers go through the scratch array once the election is done with it
+    unsigned f = 0;
+    for (unsigned i = 0; i < table->count; i++) {
+        const res_row_t *row = res_get(table, i);
+        if (row->run == run && row->term != 0) {
+            if (row->term > stats->term) {
+                stats->term = row->term;
+            }
+            scratch[f++] = row->failover;
+        }
+    }
+    if (f > 0) {
+        qsort(scratch, f, sizeof(uint32_t), compareU32);
+        stats->failovers = f;
+        stats->failoverMedian = scratch[f / 2];
+        stats->failoverMax = scratch[f - 1];
+    }
+    return n;
+}
+
+// Purpose: add a node's traffic counters to the sums of its run, the sums of
+// an older run are dropped
+//
+// table res_table_t*, the table
+// run uint16_t, the epoch the report belongs to
+// stats le_wire_stats_t*, the counters from the report
+void res_traffic_add(res_table_t *table, uint16_t run, const le_wire_stats_t *stats) {
+    res_traffic_t *traffic = &table->traffic;
+
+    if (traffic->nodes == 0 || traffic->run != run) {
+        memset(traffic, 0, sizeof(*traffic));
+        traffic->run = run;
+    }
+    traffic->nodes++;
+    for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+        traffic->rx[i] += stats->rx[i];
+        traffic->tx[i] += stats->tx[i];
+    }
+    traffic->rxBytes += stats->rxBytes;
+    traffic->txBytes += stats->txBytes;
+    traffic->sendFail += stats->sendFail;
+    traffic->ipcDrop += stats->ipcDrop;
+    traffic->parseErr += stats->parseErr;
+}
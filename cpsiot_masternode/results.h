@@ -0,0 +1,89 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Results table of the master, one row per node per election run.
+ *
+ * Rows are appended as the workers report and refer to nodes by their
+ * registry index. The table holds the last LE_MAX_RESULTS rows; once it is
+ * full the oldest row is overwritten, so repeated runs keep the most recent
+ * ones. res_stats aggregates one run for the results shell command. A node
+ * that re-elected after losing the leader adds another row for the run with
+ * the term of the re-election and the failover time.
+ *
+ * The traffic counters in the workers' reports are summed per run rather
+ * than kept per row, for the latest run only, so the table stays small.
+ */
+
+#ifndef RESULTS_H
+#define RESULTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "le_wire.h"
+
+#ifndef LE_MAX_RESULTS
+#define LE_MAX_RESULTS          (256)
+#endif
+
+#define RES_UNKNOWN             (0xFFFF)  // a leader that is not in the registry
+
+typedef struct {
+    uint16_t run;           // epoch of the election run
+    uint16_t node;          // registry index of the reporting node
+    uint16_t m;             // its m value in this run
+    uint16_t leader;        // registry index of the leader it elected
+    uint16_t leaderM;       // m value of that leader
+    uint16_t rounds;
+    uint32_t convergence;   // usec, on the node's own clock
+    uint32_t messages;
+    uint32_t started;       // election start and end, in the master's clock
+    uint32_t ended;
+    uint8_t term;           // 0 for the election the master started, then per re-election
+    uint32_t failover;      // re-elections: last heartbeat of the lost leader to the new one, usec
+} res_row_t;
+
+// the workers' traffic in one run, from the first report of each node
+typedef struct {
+    uint16_t run;
+    uint16_t nodes;         // reports summed
+    uint32_t rx[LE_WIRE_CLASSES];   // frames received per class
+    uint32_t tx[LE_WIRE_CLASSES];   // frames sent per class
+    uint32_t rxBytes;
+    uint32_t txBytes;
+    uint32_t sendFail;
+    uint32_t ipcDrop;
+    uint32_t parseErr;
+} res_traffic_t;
+
+typedef struct {
+    res_row_t rows[LE_MAX_RESULTS];
+    uint16_t head;          // oldest row
+    uint16_t count;
+    uint32_t overwritten;   // rows lost to newer ones
+    res_traffic_t traffic;  // of the latest run that reported
+} res_table_t;
+
+typedef struct {
+    uint16_t reported;      // term 0 rows of the run
+    bool agreed;            // every node elected the same leader
+    uint16_t leader;        // the first row's leader
+    uint32_t convMin;       // per node convergence, usec
+    uint32_t convMedian;
+    uint32_t convP95;
+    uint32_t convMax;
+    uint32_t network;       // first start to last end, usec
+    uint32_t messages;      // sum over all nodes
+    uint16_t failovers;     // re-election rows of the run
+    uint8_t term;           // the latest term among them
+    uint32_t failoverMedian;
+    uint32_t failoverMax;
+} res_stats_t;
+
+void res_init(res_table_t *table);
+res_row_t *res_add(res_table_t *table);
+const res_row_t *res_get(const res_table_t *table, unsigned i);
+int res_stats(const res_table_t *table, uint16_t run, res_stats_t *stats);
+void res_traffic_add(res_table_t *table, uint16_t run, const le_wire_stats_t *stats);
+
+#endif /* RESULTS_H */
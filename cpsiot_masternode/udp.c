@@ -16,6 +16,7 @@
 
 // Standard RIOT includes
 #include "thread.h"
+#include "mutex.h"
 #include "xtimer.h"
 #include "random.h"
 
@@ -23,6 +24,13 @@
 #include "net/sock/udp.h"
 #include "net/ipv6/addr.h"
 
+// Shared includes
+#include "le_wire.h"
+#include "le_topo.h"
+#include "le_sync.h"
+#include "registry.h"
+#include "results.h"
+
 #define CHANNEL                 11
 
 #define SERVER_MSG_QUEUE_SIZE   (64)
@@ -30,10 +38,75 @@
 #define IPV6_ADDRESS_LEN        (46)
 #define MAX_IPC_MESSAGE_SIZE    (128)
 
-#define MAX_NODES               (10)
+// topology storage, two entries per link; a mesh needs up to 8 per node, a
+// complete topology of N nodes N * (N - 1)
+#ifndef LE_MAX_LINKS
+#define LE_MAX_LINKS            (8 * LE_MAX_NODES)
+#endif
+
+// discovery pings every LE_DISCOVER_PING_USEC and ends once LE_EXPECTED_NODES
+// answered (0 if unknown), after LE_DISCOVER_QUIET_USEC without a new node,
+// or at the latest after LE_DISCOVER_MAX_USEC; the quiet window has to cover
+// a ping interval plus the workers' pong backoff
+#ifndef LE_EXPECTED_NODES
+#define LE_EXPECTED_NODES       (0)
+#endif
+#ifndef LE_DISCOVER_PING_USEC
+#define LE_DISCOVER_PING_USEC   (1000000)
+#endif
+#ifndef LE_DISCOVER_QUIET_USEC
+#define LE_DISCOVER_QUIET_USEC  (2500000)
+#endif
+#ifndef LE_DISCOVER_MAX_USEC
+#define LE_DISCOVER_MAX_USEC    (15000000)
+#endif
+
+// topology of the first assignment, the topo shell command changes it at runtime
+#ifndef LE_TOPO
+#define LE_TOPO                 "ring"
+#endif
+#ifndef LE_TOPO_LINKS
+#define LE_TOPO_LINKS           "bi"
+#endif
+#ifndef LE_TOPO_ROWS
+#define LE_TOPO_ROWS            (0)
+#endif
+
+// topology dissemination: at most LE_IPS_WINDOW unconfirmed ips frames in
+// flight, each sent again after LE_IPS_RTO_USEC, up to LE_IPS_RETRIES times
+#ifndef LE_IPS_WINDOW
+#define LE_IPS_WINDOW           (8)
+#endif
+#ifndef LE_IPS_RTO_USEC
+#define LE_IPS_RTO_USEC         (300000)
+#endif
+#ifndef LE_IPS_RETRIES
+#define LE_IPS_RETRIES          (5)
+#endif
+// gap between two ips frames, keeps the small packet buffer from overflowing
+#define IPS_GAP_USEC            (10000)
 
-// 1=ring, 2=line, grid, mesh
-#define MY_TOPO                 (1)
+// the start is multicast LE_START_REPEAT times, LE_START_GAP_USEC apart, and
+// names a time LE_START_LEAD_USEC ahead, so every copy arrives before it
+#ifndef LE_START_LEAD_USEC
+#define LE_START_LEAD_USEC      (200000)
+#endif
+#ifndef LE_START_REPEAT
+#define LE_START_REPEAT         (3)
+#endif
+#define LE_START_GAP_USEC       (20000)
+
+// a run ends at the latest after LE_RUN_TIMEOUT_USEC, with the results of the
+// nodes that reported; the rerun command can change it
+#ifndef LE_RUN_TIMEOUT_USEC
+#define LE_RUN_TIMEOUT_USEC     (120000000)
+#endif
+
+// from discovery on, a clock beacon goes out every LE_SYNC_PERIOD_USEC so the
+// workers can follow our clock's offset and skew
+#ifndef LE_SYNC_PERIOD_USEC
+#define LE_SYNC_PERIOD_USEC     (1000000)
+#endif
 
 #define DEBUG                   0
 
@@ -41,45 +114,541 @@
 void *_udp_server(void *args);
 int udp_send(int argc, char **argv);
 int udp_send_multi(int argc, char **argv);
+int udp_send_to(const ipv6_addr_t *addr, uint16_t port, const void *data, size_t len);
+int udp_send_multicast(uint16_t port, const void *data, size_t len);
 int udp_server(int argc, char **argv);
-int alreadyANeighbor(char **neighbors, char *ipv6);
-int getNeighborIndex(char **neighbors, char *ipv6);
-
-//External functions defs
-extern void substr(char *s, int a, int b, char *t);
-extern int indexOfSemi(char *ipv6);
-extern void extractIP(char **s, char *t);
+int udp_topo(int argc, char **argv);
+int udp_results(int argc, char **argv);
+int udp_rerun(int argc, char **argv);
 
 // Data structures (i.e. stacks, queues, message structs, etc)
-static char server_buffer[SERVER_BUFFER_SIZE];
+static uint8_t server_buffer[SERVER_BUFFER_SIZE];
 static char server_stack[THREAD_STACKSIZE_DEFAULT];
 static msg_t server_msg_queue[SERVER_MSG_QUEUE_SIZE];
 static sock_udp_t sock;
+static reg_table_t registry;
+static uint32_t topo_offsets[LE_MAX_NODES + 1];
+static uint16_t topo_adj[LE_MAX_LINKS];
+static uint8_t topo_link[LE_MAX_LINKS];
+static le_topo_t topo;
+static res_table_t results;
+static mutex_t resultsLock = MUTEX_INIT; // results and queued runs, shared with the shell
+
+// dissemination state of one node's assignment
+typedef struct {
+    uint8_t parts;          // ips frames of the assignment
+    uint8_t perFrame;       // neighbors in each of them, fewer with full addresses
+    uint8_t acked;          // frames confirmed, also the next one to send
+    uint8_t tries;          // transmissions of the current frame
+    bool inFlight;          // the current frame awaits its confirmation
+    bool failed;            // given up after LE_IPS_RETRIES
+    uint32_t sentAt;
+} ips_tx_t;
+static ips_tx_t ipsTx[LE_MAX_NODES];
 
 // State variables
 static bool server_running = false;
+static uint16_t epoch = 1; // election run, tags every election message
+static le_topo_kind_t topoKind = LE_TOPO_RING;
+static bool topoBidirectional = true;
+static uint32_t topoRows = LE_TOPO_ROWS;
+static bool topoSelected = false; // the Makefile defaults are parsed on first use
+static uint32_t lastSync = 0;   // when the last clock beacon went out
+static unsigned runsQueued = 0; // runs still to do, queued by the rerun command
+static uint64_t runTimeout = LE_RUN_TIMEOUT_USEC;
 const int SERVER_PORT = 3142;
 
-// Purpose: determine if an ipv6 address is already registered
+// Purpose: select the topology of the next assignment
 //
-// neighbors char**, list of registered neighbors
-// ipv6 char*, the address to check for
-int alreadyANeighbor(char **neighbors, char *ipv6) {
-    for(int i = 0; i < MAX_NODES; i++) {
-        if(strcmp(neighbors[i], ipv6) == 0) return 1;
+// shape char*, a name known to le_topo_parse
+// links char*, "bi" or "uni"
+// rows uint32_t, grid and mesh rows, 0 for a square-ish layout
+// return 0 on success, -1 for an unknown shape or link mode
+static int selectTopology(const char *shape, const char *links, uint32_t rows) {
+    le_topo_kind_t kind;
+    if (le_topo_parse(shape, &kind) != 0) {
+        printf("UDP: Error - unknown topology %s\n", shape);
+        return -1;
+    }
+    if (strcmp(links, "bi") != 0 && strcmp(links, "uni") != 0) {
+        printf("UDP: Error - links are bi or uni, not %s\n", links);
+        return -1;
     }
+    topoKind = kind;
+    topoBidirectional = (strcmp(links, "bi") == 0);
+    topoRows = rows;
+    topoSelected = true;
     return 0;
 }
 
-// Purpose: retrieve the internal index of an address
+// Purpose: wait for the next frame on the server socket
+//
+// remote sock_udp_ep_t*, set to the sender
+// timeout uint32_t, usec to wait
+// type int*, set to the message type, -1 if nothing usable arrived
+// return the frame length in server_buffer, 0 or less if nothing arrived
+static int receiveFrame(sock_udp_ep_t *remote, uint32_t timeout, int *type) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    int res = sock_udp_recv(&sock, server_buffer, sizeof(server_buffer), timeout, remote);
+
+    *type = -1;
+    if (res < 0) {
+        if (res != -ETIMEDOUT && res != -EAGAIN) {
+            printf("UDP: Error - failed to receive UDP, %d\n", res);
+        }
+    }
+    else if (res == 0) {
+        (void) puts("UDP: no UDP data received");
+    }
+    else {
+        *type = le_wire_type(server_buffer, res);
+        if (DEBUG == 1) {
+            ipv6_addr_to_str(ipv6, (ipv6_addr_t *)remote->addr.ipv6, IPV6_ADDRESS_LEN);
+            printf("UDP: recvd: type %d from %s\n", *type, ipv6);
+        }
+    }
+    return res;
+}
+
+// Purpose: estimate a node's clock offset from a pong, NTP style, keeping the
+// sample with the shortest round trip since it is the least skewed by queuing
+//
+// node reg_node_t*, the node that answered
+// pong le_wire_pong_t*, its timestamps of the ping it answered
+// rx uint32_t, our clock when the pong arrived
+static void clockSample(reg_node_t *node, const le_wire_pong_t *pong, uint32_t rx) {
+    uint32_t rtt;
+    uint32_t offset = le_sync_ntp(pong->pingTx, pong->rx, pong->tx, rx, &rtt);
+    if (rtt <= node->rtt) {
+        node->offset = offset;
+        node->rtt = rtt;
+    }
+}
+
+// Purpose: multicast a clock beacon if the last one is LE_SYNC_PERIOD_USEC
+// old, called from every receive loop after discovery
+//
+// force bool, send one now regardless, e.g. right before the start
+static void syncTick(bool force) {
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    uint32_t now = xtimer_now_usec();
+
+    if (!force && now - lastSync < LE_SYNC_PERIOD_USEC) {
+        return;
+    }
+    le_wire_sync_t sync = { .tx = now };
+    int len = le_wire_encode_sync(frame, sizeof(frame), &sync);
+    udp_send_multicast(SERVER_PORT, frame, len);
+    lastSync = now;
+}
+
+// Purpose: neighbors one ips frame of a node's assignment carries, all of them
+// share the width of its addresses
+//
+// reg reg_table_t*, the discovered nodes
+// i int, the node
+// return LE_WIRE_IPS_MAX if every address is link-local, otherwise LE_WIRE_IPS_FULL
+static uint8_t ipsPerFrame(const reg_table_t *reg, int i) {
+    bool compact = le_wire_compact(&reg->nodes[i].addr);
+
+    if ((uint32_t)i < topo.numNodes) {
+        for (uint32_t e = topo.offsets[i]; compact && e < topo.offsets[i + 1]; e++) {
+            compact = le_wire_compact(&reg->nodes[topo.adj[e]].addr);
+        }
+    }
+    return compact ? LE_WIRE_IPS_MAX : LE_WIRE_IPS_FULL;
+}
+
+// Purpose: generate the selected topology over the discovered nodes and
+// work out how many ips frames every node needs
+//
+// reg reg_table_t*, the discovered nodes, indexed like the topology
+static void buildTopology(const reg_table_t *reg) {
+    int numNodes = reg->count;
+
+    if (!topoSelected) {
+        selectTopology(LE_TOPO, LE_TOPO_LINKS, LE_TOPO_ROWS);
+    }
+    le_topo_init(&topo, topo_offsets, LE_MAX_NODES, topo_adj, topo_link, LE_MAX_LINKS);
+    if (numNodes == 0 || le_topo_build(&topo, topoKind, numNodes, topoRows, topoBidirectional) != 0) {
+        printf("UDP: Error - cannot build a %s topology of %d nodes (%"PRIu32" of %d link entries)\n",
+               le_topo_name(topoKind), numNodes, topo.numLinks, LE_MAX_LINKS);
+        topo.numNodes = 0;
+    }
+    printf("UDP: generating %s %s topology, %"PRIu32" nodes, %"PRIu32" links, diameter %"PRIu32"\n",
+           topoBidirectional ? "bidirectional" : "unidirectional", le_topo_name(topoKind),
+           topo.numNodes, topo.numLinks / 2, topo.diameter);
+    if ((int)topo.numNodes < numNodes) {
+        printf("UDP: %d nodes do not fit the %"PRIu32"x%"PRIu32" layout and get no neighbors\n",
+               numNodes - (int)topo.numNodes, topo.rows, topo.cols);
+    }
+
+    for (int i = 0; i < numNodes; i++) {
+        uint32_t degree = ((uint32_t)i < topo.numNodes) ? topo.offsets[i + 1] - topo.offsets[i] : 0;
+        memset(&ipsTx[i], 0, sizeof(ipsTx[i]));
+        ipsTx[i].perFrame = ipsPerFrame(reg, i);
+        // a node without neighbors still gets one frame with its m
+        ipsTx[i].parts = (degree == 0) ? 1 : (uint8_t)((degree + ipsTx[i].perFrame - 1) / ipsTx[i].perFrame);
+        if (DEBUG == 1) {
+            printf("UDP: node %d, m=%u, has %"PRIu32" neighbors\n", i, reg->nodes[i].m, degree);
+        }
+    }
+}
+
+// Purpose: send one ips frame of a node's assignment, its m, address and up to
+// perFrame neighbors; all frames but the last are flagged as more
+//
+// reg reg_table_t*, the discovered nodes
+// i int, the node
+// part uint8_t, which of its frames
+static void sendIps(const reg_table_t *reg, int i, uint8_t part) {
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    le_wire_ips_t ips = { .m = reg->nodes[i].m, .part = part };
+    ips.diameter = (topo.diameter > UINT8_MAX) ? UINT8_MAX : (uint8_t)topo.diameter;
+    ips.self = reg->nodes[i].addr;
+
+    if ((uint32_t)i < topo.numNodes) {
+        uint32_t e = topo.offsets[i] + (uint32_t)part * ipsTx[i].perFrame;
+        uint32_t end = topo.offsets[i + 1];
+        for (; e < end && ips.numNeighbors < ipsTx[i].perFrame; e++) {
+            uint8_t bit = (uint8_t)(1 << ips.numNeighbors);
+            ips.neighbors[ips.numNeighbors++] = reg->nodes[topo.adj[e]].addr;
+            ips.linksIn |= (topo.link[e] & LE_TOPO_IN) ? bit : 0;
+            ips.linksOut |= (topo.link[e] & LE_TOPO_OUT) ? bit : 0;
+        }
+        ips.more = (e < end);
+    }
+    int len = le_wire_encode_ips(frame, sizeof(frame), &ips);
+    if (len > 0) {
+        udp_send_to(&reg->nodes[i].addr, SERVER_PORT, frame, len);
+    } else {
+        char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+        printf("UDP: Error - ips frame %u of node %s with %u neighbors does not encode\n", part,
+               ipv6_addr_to_str(ipv6, &ips.self, IPV6_ADDRESS_LEN), ips.numNeighbors);
+    }
+}
+
+// Purpose: send every node its assignment with at most LE_IPS_WINDOW frames
+// awaiting confirmation, one per node; an unconfirmed frame is sent again
+// after LE_IPS_RTO_USEC, a node that never confirms is given up on
+//
+// reg reg_table_t*, the discovered nodes
+// return the number of nodes that confirmed their whole assignment
+static int disseminate(const reg_table_t *reg) {
+    sock_udp_ep_t remote;
+    int numNodes = reg->count;
+    int done = 0, failed = 0, inFlight = 0;
+    int next = 0;               // round robin start of the search for a node to serve
+    uint32_t sent = 0, resent = 0;
+    uint32_t lastSend = 0;
+    uint32_t startTime = xtimer_now_usec();
+
+    while (done + failed < numNodes) {
+        syncTick(false);
+        uint32_t now = xtimer_now_usec();
+
+        // retransmit or give up on frames that timed out
+        for (int i = 0; i < numNodes; i++) {
+            ips_tx_t *tx = &ipsTx[i];
+            if (!tx->inFlight || now - tx->sentAt < LE_IPS_RTO_USEC) {
+                continue;
+            }
+            tx->inFlight = false;
+            inFlight--;
+            if (tx->tries > LE_IPS_RETRIES) {
+                char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+                printf("UDP: Error - node %s did not confirm its topology, giving up\n",
+                       ipv6_addr_to_str(ipv6, &reg->nodes[i].addr, IPV6_ADDRESS_LEN));
+                tx->failed = true;
+                failed++;
+            }
+        }
+
+        // open the window, one frame per gap so the packet buffer keeps up
+        if (inFlight < LE_IPS_WINDOW && now - lastSend >= IPS_GAP_USEC) {
+            for (int k = 0; k < numNodes; k++) {
+                int i = (next + k) % numNodes;
+                ips_tx_t *tx = &ipsTx[i];
+                if (tx->inFlight || tx->failed || tx->acked == tx->parts) {
+                    continue;
+                }
+                sendIps(reg, i, tx->acked);
+                if (tx->tries > 0) {
+                    resent++;
+                }
+                tx->tries++;
+                tx->inFlight = true;
+                tx->sentAt = now;
+                inFlight++;
+                sent++;
+                lastSend = now;
+                next = (i + 1) % numNodes;
+                break;
+            }
+        }
+
+        int type;
+        int res = receiveFrame(&remote, IPS_GAP_USEC, &type);
+        le_wire_ips_ack_t ack;
+        if (type != LE_WIRE_IPS_ACK || le_wire_decode_ips_ack(server_buffer, res, &ack) != 0) {
+            continue;
+        }
+        int i = reg_find(reg, (ipv6_addr_t *)remote.addr.ipv6);
+        if (i < 0 || !ipsTx[i].inFlight || ack.part != ipsTx[i].acked) {
+            continue; // a late duplicate
+        }
+        ips_tx_t *tx = &ipsTx[i];
+        tx->inFlight = false;
+        inFlight--;
+        tx->tries = 0;
+        tx->acked++;
+        if (tx->acked == tx->parts) {
+            done++;
+        }
+    }
+
+    printf("UDP: topology confirmed by %d of %d nodes in %"PRIu32" ms, %"PRIu32" ips frames, %"PRIu32" retransmitted\n",
+           done, numNodes, (xtimer_now_usec() - startTime) / 1000, sent, resent);
+    return done;
+}
+
+// Purpose: print the statistics of one run, callers hold resultsLock
+//
+// run uint16_t, the epoch
+static void printStats(uint16_t run) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    res_stats_t stats;
+
+    if (res_stats(&results, run, &stats) == 0) {
+        printf("UDP: no results for run %u\n", run);
+        return;
+    }
+    printf("UDP: run %u, %u nodes reported, leader %s, %s\n", run, stats.reported,
+           (stats.leader == RES_UNKNOWN) ? "unknown" :
+           ipv6_addr_to_str(ipv6, &registry.nodes[stats.leader].addr, IPV6_ADDRESS_LEN),
+           stats.agreed ? "all agree" : "nodes DISAGREE");
+    printf("UDP: run %u, convergence min/median/p95/max %"PRIu32"/%"PRIu32"/%"PRIu32"/%"PRIu32" us, "
+           "network %"PRIu32" us, %"PRIu32" messages\n", run, stats.convMin, stats.convMedian,
+           stats.convP95, stats.convMax, stats.network, stats.messages);
+    if (stats.failovers > 0) {
+        printf("UDP: run %u, %u re-elections after leader failures (up to term %u), "
+               "failover median/max %"PRIu32"/%"PRIu32" us\n", run, stats.failovers, stats.term,
+               stats.failoverMedian, stats.failoverMax);
+    }
+
+    const res_traffic_t *traffic = &results.traffic;
+    if (traffic->nodes > 0 && traffic->run == run) {
+        printf("UDP: run %u, traffic of %u nodes, frames rx/tx:", run, traffic->nodes);
+        for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+            printf(" %s %"PRIu32"/%"PRIu32, le_wire_class_name(i), traffic->rx[i], traffic->tx[i]);
+        }
+        printf("\nUDP: run %u, %"PRIu32" bytes received, %"PRIu32" sent, %"PRIu32" send failures, "
+               "%"PRIu32" IPC drops, %"PRIu32" parse errors\n", run, traffic->rxBytes, traffic->txBytes,
+               traffic->sendFail, traffic->ipcDrop, traffic->parseErr);
+    }
+}
+
+// Purpose: record the results of a node, each node is counted once per run;
+// results of a re-election after a leader failure are stored but not counted
+//
+// remote sock_udp_ep_t*, the node that reported
+// report le_wire_results_t*, its results
+// return true if they were new and of the election we started
+static bool recordResults(const sock_udp_ep_t *remote, const le_wire_results_t *report) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    char tempipv6[IPV6_ADDRESS_LEN] = { 0 };
+    uint8_t frame[LE_WIRE_MAX_LEN];
+
+    ipv6_addr_to_str(ipv6, (ipv6_addr_t *)remote->addr.ipv6, IPV6_ADDRESS_LEN);
+    if (report->epoch != epoch) {
+        printf("UDP: results of run %u from %s are too late\n", report->epoch, ipv6);
+        return false;
+    }
+    int len = le_wire_encode(frame, sizeof(frame), LE_WIRE_RCONF);
+    udp_send_to((ipv6_addr_t *)remote->addr.ipv6, SERVER_PORT, frame, len);
+
+    int index = reg_find(&registry, (ipv6_addr_t *)remote->addr.ipv6);
+    if (index < 0) {
+        printf("UDP: results from unknown node %s\n", ipv6);
+        return false;
+    }
+    if (report->term > 0) {
+        ipv6_addr_to_str(tempipv6, &report->leader, IPV6_ADDRESS_LEN);
+        printf("UDP: Node %s re-elected %s after a leader failure (term %u), failover %"PRIu32" microseconds\n",
+               ipv6, tempipv6, report->term, report->failover);
+    } else if (registry.nodes[index].reported) {
+        printf("UDP: node %s was already confirmed\n", ipv6);
+        return false;
+    }
+
+    //Save data, one row per node and run
+    ipv6_addr_to_str(tempipv6, &report->leader, IPV6_ADDRESS_LEN);
+    printf("UDP: Node %s elected %s as leader\n",ipv6,tempipv6);
+    printf("UDP: Node %s finished in %"PRIu32" microseconds\n",ipv6,report->convergence);
+    printf("UDP: Node %s exchanged %"PRIu32" messages\n",ipv6,report->messages);
+    printf("UDP: Node %s needed %u rounds\n",ipv6,report->rounds);
+    printf("UDP: Node %s sent %"PRIu32" bytes, received %"PRIu32", %u send failures, %u IPC drops, %u parse errors\n",
+           ipv6, report->stats.txBytes, report->stats.rxBytes, report->stats.sendFail,
+           report->stats.ipcDrop, report->stats.parseErr);
+
+    mutex_lock(&resultsLock);
+    res_row_t *row = res_add(&results);
+    int leader = reg_find(&registry, &report->leader);
+    row->run = epoch;
+    row->node = (uint16_t)index;
+    row->m = registry.nodes[index].m;
+    row->leader = (leader < 0) ? RES_UNKNOWN : (uint16_t)leader;
+    row->leaderM = report->m;
+    row->rounds = report->rounds;
+    row->convergence = report->convergence;
+    row->messages = report->messages;
+    row->started = report->started;
+    row->ended = report->ended;
+    row->term = report->term;
+    row->failover = report->failover;
+    if (report->term == 0) {
+        // a re-election reports the same counters again, grown since
+        res_traffic_add(&results, epoch, &report->stats);
+    }
+    mutex_unlock(&resultsLock);
+
+    if (report->term > 0) {
+        return false;
+    }
+    registry.nodes[index].reported = true; // results confirmed
+    return true;
+}
+
+// Purpose: run one election over the nodes that take part, start them all at
+// one time and collect their results until all reported or runTimeout passed
+static void runElection(void) {
+    sock_udp_ep_t remote;
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    int numRunning = 0;
+    int numNodesFinished = 0;
+    bool finished = false;
+    int i;
+
+    for (i = 0; i < registry.count; i++) {
+        registry.nodes[i].reported = false;
+        numRunning += registry.nodes[i].running;
+    }
+
+    // one multicast names the start time, every node converts it with its
+    // offset, so all of them begin together instead of one unicast after the other
+    syncTick(true);
+    le_wire_start_t start = { .epoch = epoch, .startAt = xtimer_now_usec() + LE_START_LEAD_USEC };
+    int len = le_wire_encode_start(frame, sizeof(frame), &start);
+    for (i = 0; i < LE_START_REPEAT; i++) {
+        if (i > 0) {
+            xtimer_usleep(LE_START_GAP_USEC);
+        }
+        udp_send_multicast(SERVER_PORT, frame, len);
+    }
+
+    printf("UDP: start of run %u at %"PRIu32" announced to %d nodes\n", epoch, start.startAt, numRunning);
+
+    // termination loop, waiting for info on protocol termination, a node
+    // that hangs only costs the rest of the run's results
+    uint64_t deadline = xtimer_now_usec64() + runTimeout;
+    while (!finished) {
+        if (xtimer_now_usec64() >= deadline) {
+            printf("UDP: run %u timed out after %"PRIu32" s, %d of %d nodes reported\n",
+                   epoch, (uint32_t)(runTimeout / US_PER_SEC), numNodesFinished, numRunning);
+            break;
+        }
+        syncTick(false);
+
+        // incoming UDP, results are <epoch><m><leader><runtime><message_count><rounds><started><ended><term><failover>
+        int type;
+        int res = receiveFrame(&remote, 0.05 * US_PER_SEC, &type);
+        le_wire_results_t report;
+        if (type != LE_WIRE_RESULTS || le_wire_decode_results(server_buffer, res, &report) != 0 ||
+            !recordResults(&remote, &report)) {
+            continue;
+        }
+
+        numNodesFinished++;
+        printf("UDP: %d nodes reported so far\n",numNodesFinished);
+        if(numNodesFinished >= numRunning){
+            printf("\nUDP: All nodes have reported!\n");
+            finished = true;
+        }
+    }
+
+    // the start and end of every node are in our clock, so the
+    // network's convergence is from the first start to the last node done
+    res_stats_t stats;
+    mutex_lock(&resultsLock);
+    if (finished && res_stats(&results, epoch, &stats) > 0) {
+        printf("UDP: network converged in %"PRIu32" microseconds, first start to last node done\n",
+               stats.network);
+    }
+    printStats(epoch);
+    mutex_unlock(&resultsLock);
+}
+
+// Purpose: wait for reset confirmations for a while
 //
-// neighbors char**, list of registered neighbors
-// ipv6 char*, ipv6 to check for
-int getNeighborIndex(char **neighbors, char *ipv6) {
-    for(int i = 0; i < MAX_NODES; i++) {
-        if(strcmp(neighbors[i], ipv6) == 0) return i;
+// timeout uint32_t, usec to collect
+// left int*, nodes still to confirm, counted down
+static void collectResetAcks(uint32_t timeout, int *left) {
+    sock_udp_ep_t remote;
+    uint32_t start = xtimer_now_usec();
+
+    while (*left > 0 && xtimer_now_usec() - start < timeout) {
+        int type;
+        int res = receiveFrame(&remote, IPS_GAP_USEC, &type);
+        le_wire_reset_t ack;
+        if (type != LE_WIRE_RESET_ACK || le_wire_decode_reset(server_buffer, res, LE_WIRE_RESET_ACK, &ack) != 0 ||
+            ack.epoch != epoch) {
+            continue;
+        }
+        int i = reg_find(&registry, (ipv6_addr_t *)remote.addr.ipv6);
+        if (i >= 0 && !registry.nodes[i].running && ipsTx[i].acked == ipsTx[i].parts) {
+            registry.nodes[i].running = true;
+            (*left)--;
+        }
     }
-    return -1;
+}
+
+// Purpose: prepare every node that holds its topology for the next run with
+// a new m value; a reset is sent again after LE_IPS_RTO_USEC, up to
+// LE_IPS_RETRIES times, a node that never confirms sits out the run
+static void resetNodes(void) {
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    int left = 0;
+
+    for (int i = 0; i < registry.count; i++) {
+        registry.nodes[i].running = false;
+        if (ipsTx[i].acked == ipsTx[i].parts) {
+            registry.nodes[i].m = (random_uint32() % 254)+1;
+            left++;
+        }
+    }
+    int numNodes = left;
+
+    for (int tries = 0; tries <= LE_IPS_RETRIES && left > 0; tries++) {
+        for (int i = 0; i < registry.count; i++) {
+            if (registry.nodes[i].running || ipsTx[i].acked != ipsTx[i].parts) {
+                continue;
+            }
+            le_wire_reset_t reset = { .epoch = epoch, .m = registry.nodes[i].m };
+            int len = le_wire_encode_reset(frame, sizeof(frame), LE_WIRE_RESET, &reset);
+            udp_send_to(&registry.nodes[i].addr, SERVER_PORT, frame, len);
+            collectResetAcks(IPS_GAP_USEC, &left);
+        }
+        collectResetAcks(LE_IPS_RTO_USEC, &left);
+    }
+
+    for (int i = 0; i < registry.count; i++) {
+        if (!registry.nodes[i].running && ipsTx[i].acked == ipsTx[i].parts) {
+            printf("UDP: Error - node %s did not confirm the reset, it sits out run %u\n",
+                   ipv6_addr_to_str(ipv6, &registry.nodes[i].addr, IPV6_ADDRESS_LEN), epoch);
+        }
+    }
+    printf("UDP: %d of %d nodes reset for run %u\n", numNodes - left, numNodes, epoch);
 }
 
 // Purpose: main code for the UDP server
@@ -91,29 +660,20 @@ void *_udp_server(void *args)
     sock_udp_ep_t server = { .port = SERVER_PORT, .family = AF_INET6 };
     sock_udp_ep_t remote;
     msg_init_queue(server_msg_queue, SERVER_MSG_QUEUE_SIZE);
-    char msg_content[MAX_IPC_MESSAGE_SIZE];
     char ipv6[IPV6_ADDRESS_LEN] = { 0 };
-	char tempipv6[IPV6_ADDRESS_LEN] = { 0 };
-	char tempruntime[MAX_IPC_MESSAGE_SIZE] = { 0 };
-	char tempmessagecount[MAX_IPC_MESSAGE_SIZE] = { 0 };
-    int m_values[MAX_NODES] = { 0 };
-    int confirmed[MAX_NODES] = { 0 };
-    char mStr[5] = { 0 };
-    char portBuf[6];
-    sprintf(portBuf,"%d",SERVER_PORT);
-
-    int numNodes = 0;
-	int numNodesFinished = 0;
-	int finished = 0;
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    int len;
+
     int i;
-    char **nodes = (char**)calloc(MAX_NODES, sizeof(char*));
-    for(i = 0; i < MAX_NODES; i++) {
-        nodes[i] = (char*)calloc(IPV6_ADDRESS_LEN, sizeof(char));
-    }
+    reg_init(&registry);
+    res_init(&results);
 
     uint64_t lastDiscover = 0;
-    uint64_t wait = 5*1000000; // 5 seconds
-    int discoverLoops = 3; // 15 seconds of discovery
+    uint64_t startDiscover;
+    uint64_t lastNew;
+    int pings = 0;
+    const char *reason;
+    const int expected = LE_EXPECTED_NODES;
 
     // create the socket
     if(sock_udp_create(&sock, &server, NULL, 0) < 0) {
@@ -124,211 +684,166 @@ void *_udp_server(void *args)
     printf("UDP: Success - started UDP server on port %u\n", server.port);
 
     // main server loop
+    startDiscover = xtimer_now_usec64();
+    lastNew = startDiscover;
     while (1) {
-        // discover nodes
-        if (lastDiscover + wait < xtimer_now_usec64()) {
-            // multicast to find nodes
-            if (discoverLoops == 0) break;
-
-            char msg[5] = "ping";
-            char *argsMsg[] = { "udp_send_multi", portBuf, msg, NULL };
-            udp_send_multi(3, argsMsg);
-            discoverLoops--;
-            lastDiscover = xtimer_now_usec64();
+        uint64_t now = xtimer_now_usec64();
+        if (expected > 0 && registry.count >= expected) {
+            reason = "all expected nodes answered";
+            break;
         }
-    
-        // incoming UDP
-        int res;
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        memset(server_buffer, 0, SERVER_BUFFER_SIZE);
-
-        if ((res = sock_udp_recv(&sock, server_buffer,
-                                 sizeof(server_buffer) - 1, 0.05 * US_PER_SEC, //SOCK_NO_TIMEOUT,
-                                 &remote)) < 0) {
-            if(res != 0 && res != -ETIMEDOUT && res != -EAGAIN) 
-                printf("UDP: Error - failed to receive UDP, %d\n", res);
+        if (registry.count > 0 && now - lastNew >= LE_DISCOVER_QUIET_USEC) {
+            reason = "no new nodes in the quiet window";
+            break;
         }
-        else if (res == 0) {
-            (void) puts("UDP: no UDP data received");
+        if (now - startDiscover >= LE_DISCOVER_MAX_USEC) {
+            reason = "time limit";
+            break;
         }
-        else {
-            server_buffer[res] = '\0';
-            res = 1;
-            ipv6_addr_to_str(ipv6, (ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDRESS_LEN);
-            if (DEBUG == 1) {
-                printf("UDP: recvd: %s from %s\n", server_buffer, ipv6);
-            }
+
+        // discover nodes, unconfirmed ones answer every ping
+        if (pings == 0 || now - lastDiscover >= LE_DISCOVER_PING_USEC) {
+            // multicast to find nodes, stamped for the clock offset
+            le_wire_ping_t ping = { .tx = xtimer_now_usec() };
+            len = le_wire_encode_ping(frame, sizeof(frame), &ping);
+            udp_send_multicast(SERVER_PORT, frame, len);
+            pings++;
+            lastDiscover = now;
+        }
+    
+        // incoming UDP
+        int type;
+        int res = receiveFrame(&remote, 0.05 * US_PER_SEC, &type);
+        uint32_t rx = xtimer_now_usec();
+        if (res > 0) {
+            ipv6_addr_to_str(ipv6, (ipv6_addr_t *)remote.addr.ipv6, IPV6_ADDRESS_LEN);
         }
 
         // react to UDP message
-        if (res == 1) {
+        if (type >= 0) {
             // a node has responded to our discovery request
-            if (strncmp(server_buffer,"pong",4) == 0) {
+            le_wire_pong_t pong;
+            if (type == LE_WIRE_PONG && le_wire_decode_pong(server_buffer, res, &pong) == 0) {
                 // if node with this ipv6 is already found, ignore
-                // otherwise record them
-                int found = alreadyANeighbor(nodes, ipv6);
-                //printf("For IP=%s, found=%d\n", ipv6, found);
-                if (found == 0) {
-                    strcpy(nodes[numNodes], ipv6);
-                    printf("UDP: recorded new node, %s\n", nodes[numNodes]);
-                    m_values[numNodes] = (random_uint32() % 254)+1;
-                    numNodes++;
-                
-                    // send back discovery confirmation
-                    char msg[5] = "conf";
-                    char *argsMsg[] = { "udp_send", ipv6, portBuf, msg, NULL };
-                    udp_send(4, argsMsg);
+                // otherwise record them; a full registry turns new nodes
+                // away unconfirmed, so they sit out the run
+                ipv6_addr_t addr;
+                bool added;
+                memcpy(&addr, remote.addr.ipv6, sizeof(addr));
+                int index = reg_add(&registry, &addr, &added);
+                if (index < 0 && registry.rejected == 1) {
+                    printf("UDP: Error - registry full (%d nodes), turning away %s and later nodes\n",
+                           LE_MAX_NODES, ipv6);
+                }
+                if (added) {
+                    printf("UDP: recorded new node, %s\n", ipv6);
+                    registry.nodes[index].m = (random_uint32() % 254)+1;
+                    registry.nodes[index].rtt = UINT32_MAX;
+                    lastNew = xtimer_now_usec64();
+                }
+                // send back discovery confirmation with the node's clock
+                // offset, again if the first one was lost
+                if (index >= 0) {
+                    clockSample(&registry.nodes[index], &pong, rx);
+                    le_wire_conf_t conf = { .offset = registry.nodes[index].offset };
+                    len = le_wire_encode_conf(frame, sizeof(frame), &conf);
+                    udp_send_to(&addr, SERVER_PORT, frame, len);
                 }
             }
         }
-
-        xtimer_usleep(50000); // wait 0.05 seconds
+        // no sleep here, the receive timeout paces the loop and replies are drained at once
     }
 
-    printf("Node discovery complete, found %d nodes:\n",numNodes);
-    int c = 1;
-    for (i = 0; i < MAX_NODES; i++) {
-        if (strcmp(nodes[i],"") == 0) 
-            continue;
-        printf("%2d: %s, m=%d\n", c, nodes[i], m_values[i]);
-        c += 1;
+    printf("UDP: discovery ended after %"PRIu32" ms and %d pings, %s\n",
+           (uint32_t)((xtimer_now_usec64() - startDiscover) / 1000), pings, reason);
+    printf("Node discovery complete, found %d nodes:\n",registry.count);
+    for (i = 0; i < registry.count; i++) {
+        printf("%2d: %s, m=%u, offset=%"PRId32" us, rtt=%"PRIu32" us\n", i + 1,
+               ipv6_addr_to_str(ipv6, &registry.nodes[i].addr, IPV6_ADDRESS_LEN),
+               registry.nodes[i].m, (int32_t)registry.nodes[i].offset, registry.nodes[i].rtt);
+    }
+    if (registry.rejected > 0) {
+        printf("UDP: registry full, %"PRIu32" pongs from further nodes were turned away (LE_MAX_NODES=%d)\n",
+               registry.rejected, LE_MAX_NODES);
     }
 
-    // send out topology info to all discovered nodes
-    if (MY_TOPO == 1) {
-        // compose message, "ips:<yourIP>;<neighbor1>;<neighbor2>;
-        printf("UDP: generating ring topology\n");
-        int j;
-        for (j = 0; j < 1; j++) { // send topology info 1 time(s)
-            for (i = 0; i < numNodes; i++) {
-                int pre = (i-1);
-                int post = (i+1);
-
-                if (pre == -1) { pre = numNodes-1; }
-                if (post == numNodes) { post = 0; }
+    // send out topology info to all discovered nodes, start as soon as every
+    // node confirmed it; a node that never did sits out every run
+    buildTopology(&registry);
+    disseminate(&registry);
+    for (i = 0; i < registry.count; i++) {
+        registry.nodes[i].running = (ipsTx[i].acked == ipsTx[i].parts);
+    }
 
-                if (j == 0) {
-                    printf("UDP: node %d's neighbors are %d and %d\n", i, pre, post);
-                }
-                char msg[SERVER_BUFFER_SIZE] = "ips:";
-                memset(mStr, 0, 5);
-                sprintf(mStr, "%d;", m_values[i]);
-                
-                strcat(msg, mStr);
-                strcat(msg, nodes[i]);
-                strcat(msg, ";");
-                strcat(msg, nodes[pre]);
-                strcat(msg, ";");
-                strcat(msg, nodes[post]);
-                strcat(msg, ";");
-
-                if (j == 0) {
-                    printf("UDP: Sending node %d's info: %s\n", i, msg);
-                }
+    // the first run starts right away, further ones when the rerun command
+    // queues them; beacons keep the workers synchronized in between
+    while (1) {
+        runElection();
+        while (runsQueued == 0) {
+            int type;
+            syncTick(false);
+            int res = receiveFrame(&remote, 0.05 * US_PER_SEC, &type);
 
-                char *argsMsg[] = { "udp_send", nodes[i], portBuf, msg, NULL };
-                udp_send(4, argsMsg);
-                xtimer_usleep(100000); // wait .1 seconds
+            // late results, or a re-election after the leader failed
+            le_wire_results_t report;
+            if (type == LE_WIRE_RESULTS && le_wire_decode_results(server_buffer, res, &report) == 0) {
+                recordResults(&remote, &report);
             }
-            xtimer_usleep(1000000); // wait 1 seconds
         }
-    } 
-
-    // synchronization? tell nodes to go?
-    xtimer_usleep(5000000); // wait 5 seconds
-    for (i = 0; i < numNodes; i++) {
-        char msg[7] = "start:";
-        char *argsMsg[] = { "udp_send", nodes[i], portBuf, msg, NULL };
-        udp_send(4, argsMsg);
+        mutex_lock(&resultsLock);
+        runsQueued--;
+        mutex_unlock(&resultsLock);
+        epoch++;
+        resetNodes();
     }
 
-    printf("UDP: start messages sent\n");
-
-    // termination loop, waiting for info on protocol termination
-    while (1) {
-        // incoming UDP
-        int res;
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        memset(server_buffer, 0, SERVER_BUFFER_SIZE);
-
-        if ((res = sock_udp_recv(&sock, server_buffer,
-                                 sizeof(server_buffer) - 1, 0.05 * US_PER_SEC, //SOCK_NO_TIMEOUT,
-                                 &remote)) < 0) {
-            if(res != 0 && res != -ETIMEDOUT && res != -EAGAIN)  {
-                printf("UDP: Error - failed to receive UDP, %d\n", res);
-            }
-        }
-        else if (res == 0) {
-            (void) puts("UDP: no UDP data received");
-        }
-        else {
-            server_buffer[res] = '\0';
-            res = 1;
-            ipv6_addr_to_str(ipv6, (ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDRESS_LEN);
-            if (DEBUG == 1) {
-                printf("UDP: recvd: %s from %s\n", server_buffer, ipv6);
-            }
-        }
+    return NULL;
+}
 
-        // handle UDP message
-        if (res == 1) {
-			//Getting results from a node
-			//Form is "results;<elected_leader_id>;<runtime>;<message_count>;"
-			if (strncmp(server_buffer,"results",7) == 0) {
-				//If we are already done don't save results anymore
-				if (!finished) {
-					//TODO Save data somehow and check for reduntant data (right now the nodes will only report thier results once)
-                    char conf[6] = "rconf";
-                    char *argsMsg[] = { "udp_send", ipv6, portBuf, conf, NULL };
-                    udp_send(4, argsMsg);
-
-                    int index = getNeighborIndex(nodes,ipv6);
-                    if (confirmed[index] == 1) {
-                        printf("UDP: node %s was already confirmed\n", ipv6);
-                        continue;
-                    }
-				
-					//Save data
-					char *msg = (char*)malloc(SERVER_BUFFER_SIZE);
-                    memset(msg, 0, SERVER_BUFFER_SIZE);
-                    char *mem = msg;
-                    //chop off the results string
-					substr(server_buffer, 8, strlen(server_buffer)-8, msg);
-					
-					//Extract the elected IP
-					extractIP(&msg, tempipv6);
-					printf("UDP: Node %s elected %s as leader\n",ipv6,tempipv6);
-					
-					//Extract the run time
-					extractIP(&msg, tempruntime);
-					printf("UDP: Node %s finished in %s microseconds\n",ipv6,tempruntime);
-					
-					//Extract the message count
-					extractIP(&msg, tempmessagecount);
-					printf("UDP: Node %s exchanged %s messages\n",ipv6,tempmessagecount);
-					
-                    confirmed[index] = 1; // results confirmed
-					numNodesFinished++;
-					printf("UDP: %d nodes reported so far\n",numNodesFinished);
-					if(numNodesFinished >= numNodes){
-						printf("\nUDP: All nodes have reported!\n");
-						finished = 1;
-					}
-                    free(mem);
-				}
-				
-			}
-        }
+// Purpose: send a buffer to a specific target
+//
+// addr ipv6_addr_t*, the destination address
+// port uint16_t, the destination port
+// data void*, the payload
+// len size_t, length of the payload
+int udp_send_to(const ipv6_addr_t *addr, uint16_t port, const void *data, size_t len)
+{
+    int res;
+    sock_udp_ep_t remote = { .family = AF_INET6 };
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
 
-        xtimer_usleep(50000); // wait 0.05 seconds
+    memcpy(remote.addr.ipv6, addr, sizeof(remote.addr.ipv6));
+    if (ipv6_addr_is_link_local(addr)) {
+        /* choose first interface when address is link local */
+        gnrc_netif_t *netif = gnrc_netif_iter(NULL);
+        remote.netif = (uint16_t)netif->pid;
     }
 
-    for(i = 0; i < MAX_NODES; i++) {
-        free(nodes[i]);
+    remote.port = port;
+    if((res = sock_udp_send(NULL, data, len, &remote)) < 0) {
+        printf("UDP: Error - could not send message to %s\n",
+               ipv6_addr_to_str(ipv6, addr, IPV6_ADDRESS_LEN));
+        return -1;
+    }
+    else {
+        if (DEBUG == 1) 
+            printf("UDP: Success - sent %u bytes to %s\n", (unsigned) res,
+                   ipv6_addr_to_str(ipv6, addr, IPV6_ADDRESS_LEN));
     }
-    free(nodes);
 
-    return NULL;
+    return 0;
+}
+
+// Purpose: send a buffer to all nodes on the link, FF02::1
+//
+// port uint16_t, the destination port
+// data void*, the payload
+// len size_t, length of the payload
+int udp_send_multicast(uint16_t port, const void *data, size_t len)
+{
+    ipv6_addr_t addr;
+    ipv6_addr_set_all_nodes_multicast(&addr, IPV6_ADDR_MCAST_SCP_LINK_LOCAL);
+    return udp_send_to(&addr, port, data, len);
 }
 
 // Purpose: send a message to a specific target
@@ -337,34 +852,19 @@ void *_udp_server(void *args)
 // argv char**, list of arugments ("udp", <target-ipv6>, <port>, <message>)
 int udp_send(int argc, char **argv)
 {
-    int res;
-    sock_udp_ep_t remote = { .family = AF_INET6 };
+    ipv6_addr_t addr;
 
     if (argc != 4) {
         (void) puts("UDP: Usage - udp <ipv6-addr> <port> <payload>");
         return -1;
     }
 
-    if (ipv6_addr_from_str((ipv6_addr_t *)&remote.addr, argv[1]) == NULL) {
+    if (ipv6_addr_from_str(&addr, argv[1]) == NULL) {
         (void) puts("UDP: Error - unable to parse destination address");
         return 1;
     }
 
-    if (ipv6_addr_is_link_local((ipv6_addr_t *)&remote.addr)) {
-        /* choose first interface when address is link local */
-        gnrc_netif_t *netif = gnrc_netif_iter(NULL);
-        remote.netif = (uint16_t)netif->pid;
-    }
-
-    remote.port = atoi(argv[2]);
-    if((res = sock_udp_send(NULL, argv[3], strlen(argv[3]), &remote)) < 0) {
-        printf("UDP: Error - could not send message \"%s\" to %s\n", argv[3], argv[1]);
-    }
-    else {
-        if (DEBUG == 1) 
-            printf("UDP: Success - sent %u bytes to %s\n", (unsigned) res, argv[1]);
-    }
-
+    udp_send_to(&addr, atoi(argv[2]), argv[3], strlen(argv[3]));
     return 0;
 }
 
@@ -374,32 +874,147 @@ int udp_send(int argc, char **argv)
 // argv char**, list of arugments ("udp", <port>, <message>)
 int udp_send_multi(int argc, char **argv)
 {
-    //multicast: FF02::1
-    int res;
-    sock_udp_ep_t remote = { .family = AF_INET6 };
-    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
-
     if (argc != 3) {
         (void) puts("UDP: Usage - udp <port> <payload>");
         return -1;
     }
 
-    ipv6_addr_set_all_nodes_multicast((ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDR_MCAST_SCP_LINK_LOCAL);
+    udp_send_multicast(atoi(argv[1]), argv[2], strlen(argv[2]));
+    return 0;
+}
 
-    if (ipv6_addr_is_link_local((ipv6_addr_t *)&remote.addr)) {
-        /* choose first interface when address is link local */
-        gnrc_netif_t *netif = gnrc_netif_iter(NULL);
-        remote.netif = (uint16_t)netif->pid;
+// Purpose: show or select the topology of the next assignment, so one
+// firmware image can be benchmarked on every shape
+//
+// argc int, number of arguments (1 to 4)
+// argv char**, list of arguments ("topo", [shape], [bi|uni], [rows])
+int udp_topo(int argc, char **argv)
+{
+    if (argc > 4) {
+        (void) puts("UDP: Usage - topo [line|ring|grid|mesh|tree|star|complete] [bi|uni] [rows]");
+        return -1;
     }
-    remote.port = atoi(argv[1]);
-    ipv6_addr_to_str(ipv6, (ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDRESS_LEN);
-    if((res = sock_udp_send(NULL, argv[2], strlen(argv[2]), &remote)) < 0) {
-        printf("UDP: Error - could not send message \"%s\" to %s\n", argv[2], ipv6);
+    if (argc > 1 && selectTopology(argv[1], (argc > 2) ? argv[2] : "bi",
+                                   (argc > 3) ? (uint32_t)atoi(argv[3]) : 0) != 0) {
+        return -1;
     }
-    else {
-        if (DEBUG == 1) 
-            printf("UDP: Success - sent %u bytes to %s\n", (unsigned)res, ipv6);
+    if (!topoSelected) {
+        selectTopology(LE_TOPO, LE_TOPO_LINKS, LE_TOPO_ROWS);
+    }
+
+    printf("UDP: next topology is %s %s", topoBidirectional ? "bidirectional" : "unidirectional",
+           le_topo_name(topoKind));
+    if (topoKind == LE_TOPO_GRID || topoKind == LE_TOPO_MESH) {
+        if (topoRows == 0) {
+            printf(", square");
+        } else {
+            printf(", %"PRIu32" rows", topoRows);
+        }
+    }
+    printf("\n");
+    return 0;
+}
+
+// Purpose: print one results row as CSV or JSON
+//
+// row res_row_t*, the row
+// json bool, JSON object instead of a CSV line
+// last bool, no comma after the JSON object
+static void printRow(const res_row_t *row, bool json, bool last) {
+    char node[IPV6_ADDRESS_LEN] = { 0 };
+    char leader[IPV6_ADDRESS_LEN] = "unknown";
+
+    ipv6_addr_to_str(node, &registry.nodes[row->node].addr, IPV6_ADDRESS_LEN);
+    if (row->leader != RES_UNKNOWN) {
+        ipv6_addr_to_str(leader, &registry.nodes[row->leader].addr, IPV6_ADDRESS_LEN);
+    }
+    if (json) {
+        printf("  {\"run\": %u, \"node\": \"%s\", \"m\": %u, \"leader\": \"%s\", \"leader_m\": %u, "
+               "\"convergence_us\": %"PRIu32", \"messages\": %"PRIu32", \"rounds\": %u, "
+               "\"started\": %"PRIu32", \"ended\": %"PRIu32", \"term\": %u, \"failover_us\": %"PRIu32"}%s\n",
+               row->run, node, row->m, leader, row->leaderM, row->convergence,
+               row->messages, row->rounds, row->started, row->ended, row->term, row->failover,
+               last ? "" : ",");
+    } else {
+        printf("%u,%s,%u,%s,%u,%"PRIu32",%"PRIu32",%u,%"PRIu32",%"PRIu32",%u,%"PRIu32"\n",
+               row->run, node, row->m, leader, row->leaderM, row->convergence,
+               row->messages, row->rounds, row->started, row->ended, row->term, row->failover);
+    }
+}
+
+// Purpose: summarize a run, or dump the results table as CSV or JSON so no
+// serial log has to be scraped
+//
+// argc int, number of arguments (1 to 3)
+// argv char**, list of arguments ("results", [stats|csv|json], [run])
+int udp_results(int argc, char **argv)
+{
+    const char *format = (argc > 1) ? argv[1] : "stats";
+    bool all = (argc < 3);
+    uint16_t run = all ? epoch : (uint16_t)atoi(argv[2]);
+
+    if (argc > 3 || (strcmp(format, "stats") != 0 && strcmp(format, "csv") != 0 &&
+                     strcmp(format, "json") != 0)) {
+        (void) puts("UDP: Usage - results [stats|csv|json] [run]");
+        return -1;
+    }
+
+    mutex_lock(&resultsLock);
+    if (strcmp(format, "stats") == 0) {
+        printStats(run);
+    } else {
+        bool json = (strcmp(format, "json") == 0);
+        unsigned last = 0, n = 0;
+        // find the last row printed, so the JSON array has no trailing comma
+        for (unsigned i = 0; i < results.count; i++) {
+            if (all || res_get(&results, i)->run == run) {
+                last = i;
+                n++;
+            }
+        }
+        printf(json ? "[\n" : "run,node,m,leader,leader_m,convergence_us,messages,rounds,started,ended,term,failover_us\n");
+        for (unsigned i = 0; n > 0 && i <= last; i++) {
+            const res_row_t *row = res_get(&results, i);
+            if (all || row->run == run) {
+                printRow(row, json, i == last);
+            }
+        }
+        if (json) {
+            printf("]\n");
+        }
+    }
+    if (results.overwritten > 0) {
+        printf("UDP: %"PRIu32" older rows were overwritten (LE_MAX_RESULTS=%d)\n",
+               results.overwritten, LE_MAX_RESULTS);
+    }
+    mutex_unlock(&resultsLock);
+    return 0;
+}
+
+// Purpose: queue more election runs over the same topology, so one flash
+// and discovery serve many data points; every run resets the nodes with new
+// m values and ends at the latest after the timeout
+//
+// argc int, number of arguments (1 to 3)
+// argv char**, list of arguments ("rerun", [runs], [timeout-sec])
+int udp_rerun(int argc, char **argv)
+{
+    int runs = (argc > 1) ? atoi(argv[1]) : 1;
+    int timeout = (argc > 2) ? atoi(argv[2]) : 0;
+
+    if (argc > 3 || runs < 1 || timeout < 0) {
+        (void) puts("UDP: Usage - rerun [runs] [timeout-sec]");
+        return -1;
+    }
+
+    mutex_lock(&resultsLock);
+    if (timeout > 0) {
+        runTimeout = (uint64_t)timeout * US_PER_SEC;
     }
+    runsQueued += runs;
+    printf("UDP: %u runs queued after run %u, %"PRIu32" s timeout each\n", runsQueued, epoch,
+           (uint32_t)(runTimeout / US_PER_SEC));
+    mutex_unlock(&resultsLock);
     return 0;
 }
 
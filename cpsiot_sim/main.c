@@ -0,0 +1,344 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Command line of the leader election simulator, runs one or more
+ * seeded elections and prints a report, optionally appending CSV rows.
+ */
+
+// Standard C includes
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+
+// node pids are 2i+2 and 2i+3 and must fit a kernel_pid_t
+#define SIM_MAX_NODES           (16000)
+
+enum {
+    OPT_T1 = 256,
+    OPT_T2,
+    OPT_RTO_MIN,
+    OPT_RTO_MAX,
+    OPT_TERMINATION,
+    OPT_EPSILON,
+    OPT_HB_PERIOD,
+    OPT_HB_TIMEOUT,
+    OPT_HB_REDUNDANCY,
+    OPT_ACK_REDUNDANCY,
+    OPT_ACK_QUIET_MAX,
+    OPT_HELLO_IMIN,
+    OPT_HELLO_IMAX,
+    OPT_HELLO_AGE,
+    OPT_SETTLE,
+};
+
+static const struct option options[] = {
+    { "topology", required_argument, NULL, 't' },
+    { "nodes", required_argument, NULL, 'n' },
+    { "rows", required_argument, NULL, 'r' },
+    { "unidirectional", no_argument, NULL, 'U' },
+    { "loss", required_argument, NULL, 'l' },
+    { "latency", required_argument, NULL, 'd' },
+    { "jitter", required_argument, NULL, 'j' },
+    { "skew", required_argument, NULL, 's' },
+    { "multicast", no_argument, NULL, 'M' },
+    { "unknown-diameter", no_argument, NULL, 'u' },
+    { "k", required_argument, NULL, 'k' },
+    { "t1", required_argument, NULL, OPT_T1 },
+    { "t2", required_argument, NULL, OPT_T2 },
+    { "rto-min", required_argument, NULL, OPT_RTO_MIN },
+    { "rto-max", required_argument, NULL, OPT_RTO_MAX },
+    { "termination", required_argument, NULL, OPT_TERMINATION },
+    { "epsilon", required_argument, NULL, OPT_EPSILON },
+    { "kill-leader", no_argument, NULL, 'K' },
+    { "hb-period", required_argument, NULL, OPT_HB_PERIOD },
+    { "hb-timeout", required_argument, NULL, OPT_HB_TIMEOUT },
+    { "hb-redundancy", required_argument, NULL, OPT_HB_REDUNDANCY },
+    { "ack-redundancy", required_argument, NULL, OPT_ACK_REDUNDANCY },
+    { "ack-quiet-max", required_argument, NULL, OPT_ACK_QUIET_MAX },
+    { "autonomous", no_argument, NULL, 'A' },
+    { "hello-imin", required_argument, NULL, OPT_HELLO_IMIN },
+    { "hello-imax", required_argument, NULL, OPT_HELLO_IMAX },
+    { "hello-age", required_argument, NULL, OPT_HELLO_AGE },
+    { "settle", required_argument, NULL, OPT_SETTLE },
+    { "seed", required_argument, NULL, 'S' },
+    { "runs", required_argument, NULL, 'R' },
+    { "limit", required_argument, NULL, 'T' },
+    { "csv", required_argument, NULL, 'o' },
+    { "verbose", no_argument, NULL, 'v' },
+    { "help", no_argument, NULL, 'h' },
+    { NULL, 0, NULL, 0 },
+};
+
+static void usage(const char *name) {
+    printf("Usage: %s [options]\n"
+           "  -t, --topology NAME      line, ring, grid, mesh, tree, star, complete (ring)\n"
+           "  -n, --nodes N            number of nodes (10), no node may have more than\n"
+           "                           LE_MAX_NEIGHBORS (%d) links, e.g. star and complete\n"
+           "                           need N-1, rebuild with make LE_MAX_NEIGHBORS=N\n"
+           "  -r, --rows R             grid/mesh rows, N/R columns (square)\n"
+           "  -U, --unidirectional     links only from the lower to the higher node\n"
+           "  -l, --loss PCT           loss per reception in percent (0)\n"
+           "  -d, --latency USEC       one way latency (5000)\n"
+           "  -j, --jitter USEC        uniform extra latency (2000)\n"
+           "  -s, --skew USEC          spread of the start message arrival (0)\n"
+           "  -M, --multicast          one multicast per fan-out instead of unicasts\n"
+           "  -u, --unknown-diameter   do not tell the nodes the diameter\n"
+           "  -k, --k K                stable rounds of the K rule, minus one\n"
+           "      --t1 USEC, --t2 USEC round timers before response times are known\n"
+           "      --rto-min USEC, --rto-max USEC  bounds of the adaptive timeout\n"
+           "      --termination 0|1    K countdown or diameter + epsilon\n"
+           "      --epsilon E          extra stable rounds on top of the diameter\n"
+           "  -K, --kill-leader        kill the leader once all nodes finished, measure the failover\n"
+           "      --hb-period USEC, --hb-timeout USEC  leader heartbeats and failure detection\n"
+           "      --hb-redundancy C    copies of a heartbeat that suppress passing it on\n"
+           "      --ack-redundancy C   consistent reports that let a node skip round acks, 0 never\n"
+           "      --ack-quiet-max R    most rounds skipped after one ack\n"
+           "  -A, --autonomous         no master, nodes discover their neighbors with hellos\n"
+           "      --hello-imin USEC, --hello-imax USEC  Trickle intervals of the hellos\n"
+           "      --hello-age USEC     silence after which a neighbor is dropped (3 * imax)\n"
+           "      --settle USEC        unchanged neighborhood that starts the election\n"
+           "  -S, --seed S             seed of the first run (1)\n"
+           "  -R, --runs R             runs with seeds S, S+1, ... (1)\n"
+           "  -T, --limit SEC          simulated seconds before a run is abandoned (3600)\n"
+           "  -o, --csv FILE           append one row per run\n"
+           "  -v, --verbose            keep the nodes' console output\n"
+           "Defaults of the protocol tunables come from the worker's Makefile values.\n",
+           name, LE_MAX_NEIGHBORS);
+}
+
+// Purpose: the most links of any node, each must fit its neighbor table
+//
+// topo le_topo_t*, the built topology
+// return the largest degree
+static uint32_t maxDegree(const le_topo_t *topo) {
+    uint32_t degree = 0;
+    for (uint32_t i = 0; i < topo->numNodes; i++) {
+        uint32_t d = topo->offsets[i + 1] - topo->offsets[i];
+        degree = (d > degree) ? d : degree;
+    }
+    return degree;
+}
+
+// Purpose: print the outcome of one run
+static void printReport(FILE *out, const sim_config_t *config, const sim_report_t *report) {
+    double simSeconds = report->convergence / 1e6;
+
+    fprintf(out, "SIM: seed %"PRIu64", %s %s of %"PRIu32" nodes, diameter %"PRIu32", %s\n",
+            config->seed, config->topo.bidirectional ? "bidirectional" : "unidirectional",
+            le_topo_name(config->topo.kind), report->numNodes, config->topo.diameter,
+            config->multicast ? "multicast" : "unicast");
+    fprintf(out, "SIM:   elected %"PRIu32"/%"PRIu32", agree with the true leader (node %"PRIu32") %"PRIu32"/%"PRIu32"\n",
+            report->reported, report->numNodes, report->trueLeader, report->correct, report->numNodes);
+    fprintf(out, "SIM:   convergence %.3f s, per node min/median/max %.3f/%.3f/%.3f s\n",
+            simSeconds, report->nodeConvMin / 1e6, report->nodeConvMedian / 1e6, report->nodeConvMax / 1e6);
+    fprintf(out, "SIM:   rounds median %"PRIu32", max %"PRIu32"\n", report->roundsMedian, report->roundsMax);
+    if (report->killed != UINT32_MAX) {
+        fprintf(out, "SIM:   leader killed at %.3f s, re-elected %"PRIu32"/%"PRIu32", agree with the true leader of their part %"PRIu32"/%"PRIu32" (%"PRIu32" parts)\n",
+                report->killedAt / 1e6, report->failedOver, report->numNodes - 1,
+                report->failoverCorrect, report->numNodes - 1, report->parts);
+        fprintf(out, "SIM:   failover %.3f s after the kill, per node min/median/max %.3f/%.3f/%.3f s from the last heartbeat\n",
+                report->failoverNetwork / 1e6, report->failoverMin / 1e6, report->failoverMedian / 1e6, report->failoverMax / 1e6);
+    }
+    if (config->autonomous) {
+        fprintf(out, "SIM:   autonomous, %"PRIu64" hellos, found %"PRIu64"/%"PRIu32" links, last node started at %.3f s\n",
+                report->hellosSent, report->linksFound, config->topo.numLinks, report->lastStart / 1e6);
+    }
+    fprintf(out, "SIM:   frames sent %"PRIu64", received %"PRIu64", lost %"PRIu64", filtered %"PRIu64"\n",
+            report->framesSent, report->framesReceived, report->framesLost, report->framesFiltered);
+    fprintf(out, "SIM:   acks dropped %"PRIu64" stale, %"PRIu64" duplicate, %"PRIu64" skipped while stable\n",
+            report->dropStale, report->dropDup, report->ackSkipped);
+    fprintf(out, "SIM:   %"PRIu64" events in %.3f s wall clock, %.0fx real time\n",
+            report->events, report->wallSeconds,
+            (report->wallSeconds > 0) ? simSeconds / report->wallSeconds : 0.0);
+}
+
+// Purpose: append one CSV row, with a header if the file is new
+static void writeCsv(const char *path, const sim_config_t *config, const sim_report_t *report) {
+    bool fresh = access(path, F_OK) != 0;
+    FILE *csv = fopen(path, "a");
+    if (csv == NULL) {
+        perror(path);
+        return;
+    }
+    if (fresh) {
+        fprintf(csv, "topology,links,nodes,diameter,mode,loss,latency,jitter,k,t1,t2,rto_min,rto_max,termination,epsilon,"
+                     "seed,elected,correct,convergence_us,node_conv_median_us,node_conv_max_us,rounds_median,rounds_max,"
+                     "frames_sent,frames_received,frames_lost,drop_stale,drop_dup,wall_s,"
+                     "hb_period,hb_timeout,hb_redundancy,failover_correct,failover_us,failover_median_us,failover_max_us,"
+                     "autonomous,hellos,links_found,last_start_us,ack_redundancy,ack_quiet_max,acks_skipped\n");
+    }
+    fprintf(csv, "%s,%s,%"PRIu32",%"PRIu32",%s,%.4f,%"PRIu32",%"PRIu32",%"PRIu32",%"PRIu32",%"PRIu32",%"PRIu32",%"PRIu32",%u,%u,"
+                 "%"PRIu64",%"PRIu32",%"PRIu32",%"PRIu64",%"PRIu32",%"PRIu32",%"PRIu32",%"PRIu32","
+                 "%"PRIu64",%"PRIu64",%"PRIu64",%"PRIu64",%"PRIu64",%.3f,"
+                 "%"PRIu32",%"PRIu32",%u,%"PRIu32",%"PRIu64",%"PRIu32",%"PRIu32","
+                 "%d,%"PRIu64",%"PRIu64",%"PRIu64",%u,%u,%"PRIu64"\n",
+            le_topo_name(config->topo.kind), config->topo.bidirectional ? "bi" : "uni",
+            report->numNodes, config->topo.diameter, config->multicast ? "multicast" : "unicast", config->loss, config->latency, config->jitter,
+            config->le.k, config->le.t1, config->le.t2, config->le.rtoMin, config->le.rtoMax,
+            config->le.termination, config->le.epsilon,
+            config->seed, report->reported, report->correct, report->convergence,
+            report->nodeConvMedian, report->nodeConvMax, report->roundsMedian, report->roundsMax,
+            report->framesSent, report->framesReceived, report->framesLost, report->dropStale, report->dropDup,
+            report->wallSeconds, config->le.hbPeriod, config->le.hbTimeout, config->le.hbRedundancy,
+            report->failoverCorrect, report->failoverNetwork, report->failoverMedian, report->failoverMax,
+            config->autonomous ? 1 : 0, report->hellosSent, report->linksFound, report->lastStart,
+            config->le.ackRedundancy, config->le.ackQuietMax, report->ackSkipped);
+    fclose(csv);
+}
+
+int main(int argc, char **argv) {
+    sim_config_t config;
+    le_topo_kind_t kind = LE_TOPO_RING;
+    uint32_t numNodes = 10;
+    uint32_t rows = 0;
+    bool bidirectional = true;
+    uint32_t runs = 1;
+    const char *csvPath = NULL;
+    int opt;
+
+    memset(&config, 0, sizeof(config));
+    le_config_default(&config.le);
+    config.knownDiameter = true;
+    config.latency = 5000;
+    config.jitter = 2000;
+    config.limit = 3600ULL * 1000000;
+    config.seed = 1;
+    config.helloImin = 1000000;
+    config.helloImax = 16000000;
+    config.settle = 8000000;
+
+    while ((opt = getopt_long(argc, argv, "t:n:r:Ul:d:j:s:Muk:KAS:R:T:o:vh", options, NULL)) != -1) {
+        switch (opt) {
+            case 't':
+                if (le_topo_parse(optarg, &kind) != 0) {
+                    fprintf(stderr, "SIM: Error - unknown topology %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'n': numNodes = strtoul(optarg, NULL, 0); break;
+            case 'r': rows = strtoul(optarg, NULL, 0); break;
+            case 'U': bidirectional = false; break;
+            case 'l': config.loss = strtod(optarg, NULL) / 100.0; break;
+            case 'd': config.latency = strtoul(optarg, NULL, 0); break;
+            case 'j': config.jitter = strtoul(optarg, NULL, 0); break;
+            case 's': config.startSkew = strtoul(optarg, NULL, 0); break;
+            case 'M': config.multicast = true; break;
+            case 'u': config.knownDiameter = false; break;
+            case 'k': config.le.k = strtoul(optarg, NULL, 0); break;
+            case OPT_T1: config.le.t1 = strtoul(optarg, NULL, 0); break;
+            case OPT_T2: config.le.t2 = strtoul(optarg, NULL, 0); break;
+            case OPT_RTO_MIN: config.le.rtoMin = strtoul(optarg, NULL, 0); break;
+            case OPT_RTO_MAX: config.le.rtoMax = strtoul(optarg, NULL, 0); break;
+            case OPT_TERMINATION: config.le.termination = (uint8_t)strtoul(optarg, NULL, 0); break;
+            case OPT_EPSILON: config.le.epsilon = (uint8_t)strtoul(optarg, NULL, 0); break;
+            case 'K': config.killLeader = true; break;
+            case OPT_HB_PERIOD: config.le.hbPeriod = strtoul(optarg, NULL, 0); break;
+            case OPT_HB_TIMEOUT: config.le.hbTimeout = strtoul(optarg, NULL, 0); break;
+            case OPT_HB_REDUNDANCY: config.le.hbRedundancy = (uint8_t)strtoul(optarg, NULL, 0); break;
+            case OPT_ACK_REDUNDANCY: config.le.ackRedundancy = (uint8_t)strtoul(optarg, NULL, 0); break;
+            case OPT_ACK_QUIET_MAX: config.le.ackQuietMax = (uint8_t)strtoul(optarg, NULL, 0); break;
+            case 'A': config.autonomous = true; break;
+            case OPT_HELLO_IMIN: config.helloImin = strtoul(optarg, NULL, 0); break;
+            case OPT_HELLO_IMAX: config.helloImax = strtoul(optarg, NULL, 0); break;
+            case OPT_HELLO_AGE: config.helloAge = strtoul(optarg, NULL, 0); break;
+            case OPT_SETTLE: config.settle = strtoul(optarg, NULL, 0); break;
+            case 'S': config.seed = strtoull(optarg, NULL, 0); break;
+            case 'R': runs = strtoul(optarg, NULL, 0); break;
+            case 'T': config.limit = strtoull(optarg, NULL, 0) * 1000000; break;
+            case 'o': csvPath = optarg; break;
+            case 'v': config.verbose = true; break;
+            case 'h':
+                usage(argv[0]);
+                return 0;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (config.killLeader && config.le.hbPeriod == 0) {
+        fprintf(stderr, "SIM: Error - --kill-leader needs heartbeats, --hb-period must not be 0\n");
+        return 1;
+    }
+    if (config.autonomous && config.helloImin == 0) {
+        fprintf(stderr, "SIM: Error - --autonomous needs hellos, --hello-imin must not be 0\n");
+        return 1;
+    }
+    if (config.helloAge == 0) {
+        config.helloAge = 3 * config.helloImax;
+    }
+    if (numNodes == 0 || numNodes > SIM_MAX_NODES) {
+        fprintf(stderr, "SIM: Error - between 1 and %d nodes are supported\n", SIM_MAX_NODES);
+        return 1;
+    }
+    // a dry run sizes the storage
+    le_topo_init(&config.topo, NULL, 0, NULL, NULL, 0);
+    le_topo_build(&config.topo, kind, numNodes, rows, bidirectional);
+    uint32_t maxNodes = config.topo.numNodes, maxLinks = config.topo.numLinks;
+    uint32_t *offsets = malloc((maxNodes + 1) * sizeof(uint32_t));
+    uint16_t *adj = malloc((maxLinks ? maxLinks : 1) * sizeof(uint16_t));
+    uint8_t *link = malloc(maxLinks ? maxLinks : 1);
+    le_topo_init(&config.topo, offsets, maxNodes, adj, link, maxLinks);
+    if (offsets == NULL || adj == NULL || link == NULL ||
+        le_topo_build(&config.topo, kind, numNodes, rows, bidirectional) != 0) {
+        fprintf(stderr, "SIM: Error - cannot build a %s of %"PRIu32" nodes\n", le_topo_name(kind), numNodes);
+        return 1;
+    }
+    uint32_t degree = maxDegree(&config.topo);
+    if (degree > LE_MAX_NEIGHBORS) {
+        fprintf(stderr, "SIM: Error - a %s of %"PRIu32" nodes has nodes with %"PRIu32" links, "
+                        "the neighbor tables hold %d, rebuild with make LE_MAX_NEIGHBORS=%"PRIu32"\n",
+                le_topo_name(kind), config.topo.numNodes, degree, LE_MAX_NEIGHBORS, degree);
+        return 1;
+    }
+    if (config.topo.numNodes != numNodes) {
+        fprintf(stderr, "SIM: using a %"PRIu32"x%"PRIu32" %s, %"PRIu32" nodes\n",
+                config.topo.rows, config.topo.cols, le_topo_name(kind), config.topo.numNodes);
+    }
+    if (config.knownDiameter && config.topo.diameter > UINT8_MAX) {
+        fprintf(stderr, "SIM: warning - diameter %"PRIu32" does not fit the ips frame, nodes get %d\n",
+                config.topo.diameter, UINT8_MAX);
+    }
+
+    // the nodes print like the firmware does, keep the report apart from it
+    FILE *out = stdout;
+    if (!config.verbose) {
+        fflush(stdout);
+        out = fdopen(dup(STDOUT_FILENO), "w");
+        if (out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+            perror("SIM: stdout");
+            return 1;
+        }
+    }
+
+    uint64_t firstSeed = config.seed;
+    uint32_t failed = 0;
+    for (uint32_t run = 0; run < runs; run++) {
+        sim_report_t report;
+        config.seed = firstSeed + run;
+        sim_run(&config, &report);
+        printReport(out, &config, &report);
+        if (csvPath != NULL) {
+            writeCsv(csvPath, &config, &report);
+        }
+        if (report.correct != report.numNodes ||
+            (report.killed != UINT32_MAX && report.failoverCorrect + 1 != report.numNodes)) {
+            failed++;
+        }
+        fflush(out);
+    }
+    if (runs > 1) {
+        fprintf(out, "SIM: %"PRIu32" of %"PRIu32" runs elected the true leader on every node\n", runs - failed, runs);
+    }
+
+    free(offsets);
+    free(adj);
+    free(link);
+    return (failed > 0) ? 2 : 0;
+}
@@ -0,0 +1,30 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host stand-in for RIOT's msg.h, used by the simulator.
+ */
+
+#ifndef MSG_H
+#define MSG_H
+
+#include <inttypes.h>
+#include <stdint.h>
+
+typedef int16_t kernel_pid_t;
+
+#define PRIkernel_pid           PRIi16
+#define KERNEL_PID_UNDEF        (0)
+
+typedef struct {
+    kernel_pid_t sender_pid;
+    uint16_t type;
+    union {
+        void *ptr;
+        uint32_t value;
+    } content;
+} msg_t;
+
+int msg_init_queue(msg_t *array, int num);
+int msg_receive(msg_t *m);
+
+#endif /* MSG_H */
@@ -0,0 +1,38 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host stand-in for RIOT's net/ipv6/addr.h, used by the simulator.
+ */
+
+#ifndef NET_IPV6_ADDR_H
+#define NET_IPV6_ADDR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define IPV6_ADDR_MAX_STR_LEN   (46)
+
+typedef union {
+    uint8_t u8[16];
+    uint16_t u16[8];
+    uint32_t u32[4];
+    uint64_t u64[2];
+} ipv6_addr_t;
+
+char *ipv6_addr_to_str(char *result, const ipv6_addr_t *addr, uint8_t result_len);
+
+static inline bool ipv6_addr_equal(const ipv6_addr_t *a, const ipv6_addr_t *b) {
+    return memcmp(a, b, sizeof(ipv6_addr_t)) == 0;
+}
+
+static inline bool ipv6_addr_is_link_local(const ipv6_addr_t *addr) {
+    return addr->u8[0] == 0xfe && (addr->u8[1] & 0xc0) == 0x80;
+}
+
+static inline bool ipv6_addr_is_unspecified(const ipv6_addr_t *addr) {
+    static const ipv6_addr_t unspecified;
+    return ipv6_addr_equal(addr, &unspecified);
+}
+
+#endif /* NET_IPV6_ADDR_H */
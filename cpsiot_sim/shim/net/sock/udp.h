@@ -0,0 +1,25 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host stand-in for RIOT's net/sock/udp.h, only the endpoint type.
+ */
+
+#ifndef NET_SOCK_UDP_H
+#define NET_SOCK_UDP_H
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "net/ipv6/addr.h"
+
+typedef struct {
+    int family;
+    union {
+        uint8_t ipv6[16];
+        uint32_t ipv4_u32;
+    } addr;
+    uint16_t netif;
+    uint16_t port;
+} sock_udp_ep_t;
+
+#endif /* NET_SOCK_UDP_H */
@@ -0,0 +1,14 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host stand-in for RIOT's random.h, drawn from the run's seed.
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+uint32_t random_uint32(void);
+
+#endif /* RANDOM_H */
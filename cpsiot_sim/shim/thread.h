@@ -0,0 +1,25 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host stand-in for RIOT's thread.h, used by the simulator.
+ *
+ * Simulated nodes have no threads, thread_getpid() names the node whose
+ * event is being processed.
+ */
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "msg.h"
+
+#define THREAD_STACKSIZE_DEFAULT    (1024)
+#define THREAD_PRIORITY_MAIN        (7)
+#define THREAD_CREATE_STACKTEST     (8)
+
+typedef void *(*thread_task_func_t)(void *arg);
+
+kernel_pid_t thread_create(char *stack, int stacksize, uint8_t priority, int flags,
+                           thread_task_func_t function, void *arg, const char *name);
+kernel_pid_t thread_getpid(void);
+
+#endif /* THREAD_H */
@@ -0,0 +1,22 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host stand-in for RIOT's xtimer.h, timers are simulator events.
+ */
+
+#ifndef XTIMER_H
+#define XTIMER_H
+
+#include <stdint.h>
+
+#include "msg.h"
+
+typedef struct {
+    uint32_t token;     // id of the pending simulator event, 0 if not armed
+} xtimer_t;
+
+uint32_t xtimer_now_usec(void);
+void xtimer_set_msg(xtimer_t *timer, uint32_t offset, msg_t *msg, kernel_pid_t target_pid);
+void xtimer_remove(xtimer_t *timer);
+
+#endif /* XTIMER_H */
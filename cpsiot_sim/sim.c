@@ -0,0 +1,815 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Event queue, radio and UDP thread stand-in of the simulator.
+ *
+ * Node i has the protocol "thread" 2i+2 and the UDP "thread" 2i+3 and the
+ * link-local address fe80::ff:fe00:<i+1>. The UDP side mirrors the worker's
+ * udp.c: frames are encoded with le_wire, fanned out as paced unicasts (or
+ * one multicast), filtered by the neighbor table and decoded again on
+ * reception, so the frame counts match what the firmware would report.
+ *
+ * With autonomous there is no master: the tables start empty, the UDP side
+ * sends Trickle-paced hellos over the topology links like the worker built
+ * with LE_AUTONOMOUS, and every node starts by itself once its neighborhood
+ * settled or a neighbor's le_m? arrives.
+ *
+ * With killLeader the run goes on after every node finished: the true leader
+ * is killed at a random time within the next heartbeat period and the run
+ * ends once every survivor reported a re-election.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ipc.h"
+#include "sim.h"
+
+#define SERVER_PORT             (3142)
+
+typedef enum {
+    SIM_EV_TIMER,       // an xtimer_set_msg expired
+    SIM_EV_FANOUT,      // pacing timer of a unicast fan-out
+    SIM_EV_START,       // the master's start message reaches a node
+    SIM_EV_FRAME,       // a frame reaches a node's UDP thread
+    SIM_EV_HELLO,       // Trickle timer of the hellos
+} sim_ev_kind_t;
+
+typedef struct {
+    uint64_t time;
+    uint64_t seq;           // keeps events at the same time in FIFO order
+    uint32_t node;
+    uint8_t kind;
+    union {
+        struct {
+            xtimer_t *timer;
+            uint32_t token;
+            kernel_pid_t pid;
+            msg_t msg;
+        } timer;
+        uint32_t fanoutGen;
+        uint32_t helloGen;
+        struct {
+            uint32_t src;
+            uint8_t len;
+            uint8_t data[LE_WIRE_MAX_LEN];
+        } frame;
+    };
+} sim_event_t;
+
+// Data structures (i.e. stacks, queues, message structs, etc)
+static struct {
+    const sim_config_t *config;
+    sim_node_t *nodes;
+    uint32_t numNodes;
+    uint64_t now;
+    uint32_t current;       // node whose event is processed
+    uint32_t printed;       // node of the last verbose header
+    sim_event_t *heap;      // binary min-heap on (time, seq)
+    size_t heapLen;
+    size_t heapCap;
+    uint64_t seq;
+    uint32_t timerTokens;
+    uint64_t rng;
+    uint32_t finished;
+    uint32_t failedOver;
+    uint32_t killed;        // UINT32_MAX until the leader is killed
+    uint64_t killAt;        // 0 until every node finished
+    uint64_t killedAt;
+    uint64_t events;
+    uint64_t hellosSent;
+    uint64_t lastStart;
+    uint64_t framesSent;
+    uint64_t framesReceived;
+    uint64_t framesLost;
+    uint64_t framesFiltered;
+} sim;
+
+// Purpose: splitmix64, reproducible from the run's seed
+static uint64_t nextRandom(void) {
+    uint64_t z = (sim.rng += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Purpose: random_uint32 of the nodes, from the same stream
+uint32_t sim_random(void) {
+    return (uint32_t)nextRandom();
+}
+
+// Purpose: uniform in [0, 1)
+static double uniform(void) {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static bool earlier(const sim_event_t *a, const sim_event_t *b) {
+    return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+// Purpose: queue an event, time and seq are filled in
+//
+// ev sim_event_t*, the event
+// delay uint64_t, usec from now
+static void schedule(sim_event_t *ev, uint64_t delay) {
+    if (sim.heapLen == sim.heapCap) {
+        sim.heapCap = sim.heapCap ? 2 * sim.heapCap : 4096;
+        sim.heap = realloc(sim.heap, sim.heapCap * sizeof(sim_event_t));
+        if (sim.heap == NULL) {
+            fprintf(stderr, "SIM: Error - out of memory for %zu events\n", sim.heapCap);
+            exit(1);
+        }
+    }
+    ev->time = sim.now + delay;
+    ev->seq = sim.seq++;
+
+    size_t i = sim.heapLen++;
+    while (i > 0 && earlier(ev, &sim.heap[(i - 1) / 2])) {
+        sim.heap[i] = sim.heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sim.heap[i] = *ev;
+}
+
+// Purpose: take the earliest event off the queue
+static void pop(sim_event_t *ev) {
+    *ev = sim.heap[0];
+    sim_event_t last = sim.heap[--sim.heapLen];
+    size_t i = 0;
+    while (1) {
+        size_t c = 2 * i + 1;
+        if (c >= sim.heapLen) {
+            break;
+        }
+        if (c + 1 < sim.heapLen && earlier(&sim.heap[c + 1], &sim.heap[c])) {
+            c++;
+        }
+        if (!earlier(&sim.heap[c], &last)) {
+            break;
+        }
+        sim.heap[i] = sim.heap[c];
+        i = c;
+    }
+    sim.heap[i] = last;
+}
+
+static kernel_pid_t protocolPid(uint32_t node) {
+    return (kernel_pid_t)(2 * node + 2);
+}
+
+static kernel_pid_t udpPid(uint32_t node) {
+    return (kernel_pid_t)(2 * node + 3);
+}
+
+// Purpose: the link-local address of a node
+static void nodeAddr(uint32_t node, ipv6_addr_t *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->u8[0] = 0xfe;
+    addr->u8[1] = 0x80;
+    addr->u8[11] = 0xff;
+    addr->u8[12] = 0xfe;
+    addr->u8[13] = (uint8_t)((node + 1) >> 16);
+    addr->u8[14] = (uint8_t)((node + 1) >> 8);
+    addr->u8[15] = (uint8_t)(node + 1);
+}
+
+// Purpose: the node behind an address, see nodeAddr
+static uint32_t addrNode(const uint8_t *addr) {
+    return (((uint32_t)addr[13] << 16) | ((uint32_t)addr[14] << 8) | addr[15]) - 1;
+}
+
+uint64_t sim_now(void) {
+    return sim.now;
+}
+
+kernel_pid_t sim_current_pid(void) {
+    return protocolPid(sim.current);
+}
+
+// Purpose: arm a timer, re-arming replaces the pending event
+void sim_timer(xtimer_t *timer, uint32_t offset, const msg_t *msg, kernel_pid_t pid) {
+    sim_event_t ev;
+    if (++sim.timerTokens == 0) {
+        sim.timerTokens = 1;
+    }
+    timer->token = sim.timerTokens;
+
+    ev.kind = SIM_EV_TIMER;
+    ev.node = (uint32_t)(pid - 2) / 2;
+    ev.timer.timer = timer;
+    ev.timer.token = timer->token;
+    ev.timer.pid = pid;
+    ev.timer.msg = *msg;
+    schedule(&ev, offset);
+}
+
+// Purpose: put a frame on the air towards one receiver, subject to loss and latency
+static void transmitTo(uint32_t src, uint32_t dst, const uint8_t *frame, uint8_t len) {
+    const sim_config_t *config = sim.config;
+    if (config->loss > 0 && uniform() < config->loss) {
+        sim.framesLost++;
+        return;
+    }
+
+    sim_event_t ev;
+    ev.kind = SIM_EV_FRAME;
+    ev.node = dst;
+    ev.frame.src = src;
+    ev.frame.len = len;
+    memcpy(ev.frame.data, frame, len);
+    schedule(&ev, config->latency + (config->jitter ? nextRandom() % (config->jitter + 1) : 0));
+}
+
+// Purpose: count one transmission of the node, as countMsgOut does
+static void countOut(sim_node_t *n) {
+    sim.framesSent++;
+    if (n->running) {
+        n->framesOut++;
+    }
+}
+
+// Purpose: unicast the pending fan-out frame to the next neighbor, as fanoutStep in udp.c
+static void fanoutStep(uint32_t node) {
+    sim_node_t *n = &sim.nodes[node];
+    while (n->fanoutNext < n->neighbors->count && !(n->neighbors->entries[n->fanoutNext].link & LE_NBR_OUT)) {
+        n->fanoutNext++;
+    }
+    if (n->fanoutNext >= n->neighbors->count) {
+        return;
+    }
+    countOut(n);
+    transmitTo(node, addrNode(n->neighbors->entries[n->fanoutNext].ep.addr.ipv6), n->fanoutFrame, n->fanoutLen);
+    n->fanoutNext++;
+
+    if (n->fanoutNext < n->neighbors->count) {
+        sim_event_t ev;
+        ev.kind = SIM_EV_FANOUT;
+        ev.node = node;
+        ev.fanoutGen = n->fanoutGen;
+        schedule(&ev, SIM_FANOUT_GAP_USEC);
+    }
+}
+
+// Purpose: send a protocol frame to all neighbors, as fanout in udp.c; a
+// multicast reaches every node in radio range, i.e. every topology link
+static void fanout(uint32_t node, const uint8_t *frame, int len) {
+    sim_node_t *n = &sim.nodes[node];
+    const le_topo_t *topo = &sim.config->topo;
+    if (len <= 0) {
+        return;
+    }
+    if (sim.config->multicast) {
+        countOut(n);
+        for (uint32_t e = topo->offsets[node]; e < topo->offsets[node + 1]; e++) {
+            if (topo->link[e] & LE_TOPO_OUT) {
+                transmitTo(node, topo->adj[e], frame, (uint8_t)len);
+            }
+        }
+        return;
+    }
+
+    memcpy(n->fanoutFrame, frame, len);
+    n->fanoutLen = (uint8_t)len;
+    n->fanoutNext = 0;
+    n->fanoutGen++;
+    fanoutStep(node);
+}
+
+// Purpose: arm the hello timer of a node, as helloArm in udp.c
+static void helloArm(uint32_t node, uint32_t delay) {
+    sim_node_t *n = &sim.nodes[node];
+    sim_event_t ev;
+    ev.kind = SIM_EV_HELLO;
+    ev.node = node;
+    ev.helloGen = ++n->helloGen;
+    schedule(&ev, delay);
+}
+
+// Purpose: a neighbor came or went, as helloChanged in udp.c
+static void helloChanged(uint32_t node) {
+    sim_node_t *n = &sim.nodes[node];
+    n->nbrChanged = sim.now;
+    uint32_t delay = le_trickle_inconsistent(&n->hello, sim_random());
+    if (delay > 0) {
+        helloArm(node, delay);
+    }
+}
+
+// Purpose: start the election without a master, as autoStart in udp.c
+static void autoStart(uint32_t node) {
+    sim_node_t *n = &sim.nodes[node];
+    if (n->autoStarted || n->neighbors->count == 0) {
+        return;
+    }
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
+    }
+    n->autoStarted = true;
+    n->running = true;
+    sim.lastStart = sim.now;
+    event->start.epoch = 1;
+    ipc_send(protocolPid(node), IPC_RX_START, event);
+}
+
+// Purpose: the hello timer fired, say hello over every link in radio range,
+// age out the silent neighbors unless an election has the table pinned, and
+// start once the neighborhood settled
+static void helloExpire(uint32_t node) {
+    sim_node_t *n = &sim.nodes[node];
+    const le_topo_t *topo = &sim.config->topo;
+    bool transmit;
+
+    helloArm(node, le_trickle_expire(&n->hello, sim_random(), &transmit));
+    if (transmit) {
+        uint8_t frame[LE_WIRE_MAX_LEN];
+        int len = le_wire_encode(frame, sizeof(frame), LE_WIRE_HELLO);
+        countOut(n);
+        sim.hellosSent++;
+        for (uint32_t e = topo->offsets[node]; e < topo->offsets[node + 1]; e++) {
+            if (topo->link[e] & LE_TOPO_OUT) {
+                transmitTo(node, topo->adj[e], frame, (uint8_t)len);
+            }
+        }
+    }
+
+    uint16_t i = 0;
+    while (!n->neighbors->pinned && i < n->neighbors->count) {
+        le_nbr_t *nbr = &n->neighbors->entries[i];
+        if ((uint32_t)sim.now - nbr->heard <= sim.config->helloAge) {
+            i++;
+            continue;
+        }
+        le_nbr_remove(n->neighbors, &nbr->addr);
+        helloChanged(node);
+    }
+    if (sim.now - n->nbrChanged >= sim.config->settle) {
+        autoStart(node);
+    }
+}
+
+// Purpose: a hello arrived, as helloHeard in udp.c
+static void helloHeard(uint32_t node, const ipv6_addr_t *remote) {
+    sim_node_t *n = &sim.nodes[node];
+    int nbr = le_nbr_find(n->neighbors, remote);
+
+    if (nbr >= 0) {
+        le_trickle_hear(&n->hello);
+        return; // heard was set on reception
+    }
+    if (n->neighbors->pinned) {
+        return;
+    }
+    nbr = le_nbr_add(n->neighbors, remote, LE_NBR_BOTH, SERVER_PORT, 0);
+    if (nbr >= 0) {
+        n->neighbors->entries[nbr].heard = (uint32_t)sim.now;
+        helloChanged(node);
+    }
+}
+
+// Purpose: the UDP thread takes an event from its protocol thread
+static void udpFromProtocol(uint32_t node, msg_t *msg) {
+    sim_node_t *n = &sim.nodes[node];
+    ipc_event_t *event = (ipc_event_t *)msg->content.ptr;
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    int len = -1;
+
+    if (msg->type == IPC_TX_QUERY) {
+        n->running = true;
+        len = le_wire_encode_query(frame, sizeof(frame), &event->query);
+        fanout(node, frame, len);
+    } else if (msg->type == IPC_TX_ACK) {
+        len = le_wire_encode_ack(frame, sizeof(frame), &event->ack);
+        fanout(node, frame, len);
+    } else if (msg->type == IPC_TX_DONE) {
+        len = le_wire_encode_done(frame, sizeof(frame), &event->done);
+        fanout(node, frame, len);
+    } else if (msg->type == IPC_TX_HB) {
+        len = le_wire_encode_hb(frame, sizeof(frame), &event->hb);
+        fanout(node, frame, len);
+    } else if (msg->type == IPC_TX_RESULTS && event->results.term > 0) {
+        // re-elected after a leader failure, keep the latest term's outcome
+        if (!n->failedOver) {
+            sim.failedOver++;
+        }
+        n->failover = event->results;
+        n->failedOver = true;
+    } else if (msg->type == IPC_TX_RESULTS && !n->reported) {
+        // the report to the master is not simulated, only recorded
+        n->results = event->results;
+        n->results.messages = n->framesIn + n->framesOut;
+        n->reported = true;
+        n->finishedAt = sim.now;
+    }
+    ipc_free(event);
+}
+
+// Purpose: a frame arrived at the UDP thread, filter and decode it for the
+// protocol thread
+static void udpReceive(uint32_t node, uint32_t src, const uint8_t *data, uint8_t len) {
+    sim_node_t *n = &sim.nodes[node];
+    const ipv6_addr_t *remote = &sim.nodes[src].addr;
+    int type = le_wire_type(data, len);
+    uint16_t ipcType = 0;
+    int res = -1;
+
+    if (type < 0) {
+        return;
+    }
+    int nbr = le_nbr_find(n->neighbors, remote);
+    if (sim.config->autonomous) {
+        if (nbr >= 0) {
+            n->neighbors->entries[nbr].heard = (uint32_t)sim.now; // any frame shows it is alive
+        }
+        if (type == LE_WIRE_HELLO) {
+            sim.framesReceived++;
+            if (n->running) {
+                n->framesIn++;
+            }
+            helloHeard(node, remote);
+            return;
+        }
+        if ((type == LE_WIRE_QUERY || type == LE_WIRE_ACK) && nbr >= 0) {
+            autoStart(node); // a neighbor settled before us, join it
+        }
+    }
+    if (nbr < 0 || !(n->neighbors->entries[nbr].link & LE_NBR_IN)) {
+        // multicast reaches everyone in radio range, keep configured (incoming) links only
+        n->framesFiltered++;
+        sim.framesFiltered++;
+        return;
+    }
+    sim.framesReceived++;
+    if (n->running) {
+        n->framesIn++;
+    }
+
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
+    }
+    if (type == LE_WIRE_QUERY) {
+        res = le_wire_decode_query(data, len, &event->query);
+        ipcType = IPC_RX_QUERY;
+    } else if (type == LE_WIRE_ACK) {
+        res = le_wire_decode_ack(data, len, &event->ack);
+        ipcType = IPC_RX_ACK;
+    } else if (type == LE_WIRE_DONE) {
+        res = le_wire_decode_done(data, len, &event->done);
+        ipcType = IPC_RX_DONE;
+    } else if (type == LE_WIRE_HB) {
+        res = le_wire_decode_hb(data, len, &event->hb);
+        ipcType = IPC_RX_HB;
+    }
+    if (res != 0) {
+        ipc_free(event);
+        return;
+    }
+    event->src = *remote;
+    ipc_send(protocolPid(node), ipcType, event);
+}
+
+// Purpose: hand a message to a thread of a node and run it to completion
+//
+// pid kernel_pid_t, a protocol or UDP thread
+// msg msg_t*, the message, typed events pass their block on
+// return 1 if delivered, 0 for an unknown thread
+int sim_deliver(kernel_pid_t pid, msg_t *msg) {
+    uint32_t node = (uint32_t)(pid - 2) / 2;
+    if (pid < 2 || node >= sim.numNodes) {
+        return 0;
+    }
+    if (pid == udpPid(node)) {
+        udpFromProtocol(node, msg);
+        return 1;
+    }
+
+    sim_node_t *n = &sim.nodes[node];
+    uint32_t caller = sim.current;
+    le_phase_t before = n->le.phase;
+
+    sim.current = node;
+    if (sim.config->verbose && sim.printed != node) {
+        printf("SIM: t=%.6f node %"PRIu32"\n", (sim.now - SIM_START_USEC) / 1e6, node);
+        sim.printed = node;
+    }
+    le_handle(&n->le, msg);
+    if (before != LE_PHASE_FINISHED && n->le.phase == LE_PHASE_FINISHED) {
+        sim.finished++;
+    }
+    sim.current = caller;
+    return 1;
+}
+
+// Purpose: process one event
+static void dispatch(sim_event_t *ev) {
+    sim_node_t *n = &sim.nodes[ev->node];
+
+    if (n->dead) {
+        return; // frames to it are lost, its timers never fire
+    }
+    switch (ev->kind) {
+        case SIM_EV_TIMER:
+            if (ev->timer.timer->token != ev->timer.token) {
+                return; // removed or re-armed
+            }
+            ev->timer.timer->token = 0;
+            sim_deliver(ev->timer.pid, &ev->timer.msg);
+            break;
+        case SIM_EV_FANOUT:
+            if (ev->fanoutGen == n->fanoutGen) {
+                fanoutStep(ev->node);
+            }
+            break;
+        case SIM_EV_START: {
+            ipc_event_t *event = ipc_alloc();
+            if (event != NULL) {
+                n->running = true;
+                event->start.epoch = 1;
+                ipc_send(protocolPid(ev->node), IPC_RX_START, event);
+            }
+            break;
+        }
+        case SIM_EV_FRAME:
+            udpReceive(ev->node, ev->frame.src, ev->frame.data, ev->frame.len);
+            break;
+        case SIM_EV_HELLO:
+            if (ev->helloGen == n->helloGen) {
+                helloExpire(ev->node);
+            }
+            break;
+    }
+}
+
+// Purpose: create the nodes and give them their topology, as the master would,
+// or only their address and m value if they discover it themselves; main
+// has checked that every node's links fit its neighbor table
+static void setup(void) {
+    const sim_config_t *config = sim.config;
+    const le_topo_t *topo = &config->topo;
+
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        sim_node_t *n = &sim.nodes[i];
+        nodeAddr(i, &n->addr);
+        n->m = (uint16_t)((nextRandom() % 254) + 1);
+        n->neighbors = malloc(sizeof(le_nbr_table_t));
+        if (n->neighbors == NULL) {
+            fprintf(stderr, "SIM: Error - out of memory for %"PRIu32" neighbor tables\n", sim.numNodes);
+            exit(1);
+        }
+        le_nbr_init(n->neighbors);
+        for (uint32_t e = topo->offsets[i]; e < topo->offsets[i + 1] && !config->autonomous; e++) {
+            ipv6_addr_t addr;
+            nodeAddr(topo->adj[e], &addr);
+            uint8_t link = ((topo->link[e] & LE_TOPO_IN) ? LE_NBR_IN : 0) |
+                           ((topo->link[e] & LE_TOPO_OUT) ? LE_NBR_OUT : 0);
+            le_nbr_add(n->neighbors, &addr, link, SERVER_PORT, 0);
+        }
+        le_init(&n->le, &config->le, n->neighbors);
+    }
+
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        sim_node_t *n = &sim.nodes[i];
+        msg_t msg;
+        msg.type = IPC_UDP_PID;
+        msg.content.value = (uint32_t)udpPid(i);
+        sim_deliver(protocolPid(i), &msg);
+
+        ipc_event_t *event = ipc_alloc();
+        if (event == NULL) {
+            continue;
+        }
+        event->ips.m = n->m;
+        if (config->knownDiameter && !config->autonomous) {
+            event->ips.diameter = (topo->diameter > UINT8_MAX) ? UINT8_MAX : (uint8_t)topo->diameter;
+        }
+        event->ips.self = n->addr;
+        event->ips.more = false;
+        event->ips.numNeighbors = 0; // already in the table
+        sim.current = i;
+        ipc_send(protocolPid(i), IPC_RX_IPS, event);
+
+        if (config->autonomous) {
+            le_trickle_init(&n->hello, config->helloImin, config->helloImax, 0);
+            n->nbrChanged = sim.now;
+            helloArm(i, le_trickle_start(&n->hello, sim_random()));
+            continue;
+        }
+        sim_event_t ev;
+        ev.kind = SIM_EV_START;
+        ev.node = i;
+        schedule(&ev, config->startSkew ? nextRandom() % (config->startSkew + 1) : 0);
+    }
+}
+
+static int compareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Purpose: the node every live node should elect, smallest m and equal m
+// to the smaller address, the lower index
+static uint32_t trueLeader(void) {
+    uint32_t best = UINT32_MAX;
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        if (!sim.nodes[i].dead && (best == UINT32_MAX || sim.nodes[i].m < sim.nodes[best].m)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Purpose: the true leader of every survivor's part of the network, the
+// parts are what is left connected, ignoring link direction
+//
+// leader uint32_t*, per node, the best node of its part, UINT32_MAX for the dead
+// return the number of parts
+static uint32_t partLeaders(uint32_t *leader) {
+    const le_topo_t *topo = &sim.config->topo;
+    uint32_t *queue = malloc(sim.numNodes * sizeof(uint32_t));
+    uint32_t parts = 0;
+
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        leader[i] = UINT32_MAX;
+    }
+    for (uint32_t root = 0; root < sim.numNodes; root++) {
+        if (sim.nodes[root].dead || leader[root] != UINT32_MAX) {
+            continue;
+        }
+        uint32_t head = 0, tail = 0, best = root;
+        leader[root] = root;
+        queue[tail++] = root;
+        while (head < tail) {
+            uint32_t u = queue[head++];
+            if (sim.nodes[u].m < sim.nodes[best].m) {
+                best = u;
+            }
+            for (uint32_t e = topo->offsets[u]; e < topo->offsets[u + 1]; e++) {
+                uint32_t v = topo->adj[e];
+                if (!sim.nodes[v].dead && leader[v] == UINT32_MAX) {
+                    leader[v] = root;
+                    queue[tail++] = v;
+                }
+            }
+        }
+        // the queue holds the part in visiting order, the root's index is its smallest
+        for (uint32_t j = 0; j < tail; j++) {
+            leader[queue[j]] = best;
+        }
+        parts++;
+    }
+    free(queue);
+    return parts;
+}
+
+// Purpose: the survivors' re-election, once the leader was killed
+static void summarizeFailover(sim_report_t *report) {
+    uint32_t *failover = malloc(sim.numNodes * sizeof(uint32_t));
+    uint32_t *leader = malloc(sim.numNodes * sizeof(uint32_t));
+    uint32_t count = 0;
+
+    report->parts = partLeaders(leader);
+    report->killedAt = sim.killedAt - SIM_START_USEC;
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        sim_node_t *n = &sim.nodes[i];
+        if (n->dead || !n->failedOver) {
+            continue;
+        }
+        uint32_t best = leader[i];
+        if (n->failover.m == sim.nodes[best].m && ipv6_addr_equal(&n->failover.leader, &sim.nodes[best].addr)) {
+            report->failoverCorrect++;
+        }
+        // the failover results end on the node's clock, which is the simulator's
+        uint64_t ended = n->failover.started + (uint64_t)n->failover.convergence;
+        if (ended > sim.killedAt && ended - sim.killedAt > report->failoverNetwork) {
+            report->failoverNetwork = ended - sim.killedAt;
+        }
+        failover[count++] = n->failover.failover;
+    }
+    free(leader);
+    report->failedOver = count;
+    if (count > 0) {
+        qsort(failover, count, sizeof(uint32_t), compareU32);
+        report->failoverMin = failover[0];
+        report->failoverMedian = failover[count / 2];
+        report->failoverMax = failover[count - 1];
+    }
+    free(failover);
+}
+
+// Purpose: summarize the nodes' outcome
+static void summarize(sim_report_t *report) {
+    uint32_t *conv = malloc(sim.numNodes * sizeof(uint32_t));
+    uint32_t *rounds = malloc(sim.numNodes * sizeof(uint32_t));
+    uint32_t best = (sim.killed != UINT32_MAX) ? sim.killed : trueLeader();
+
+    report->trueLeader = best;
+    report->killed = sim.killed;
+    if (sim.killed != UINT32_MAX) {
+        summarizeFailover(report);
+    }
+    report->numNodes = sim.numNodes;
+    report->finished = sim.finished;
+
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        sim_node_t *n = &sim.nodes[i];
+        report->dropStale += n->le.dropStaleTotal + n->le.dropStale;
+        report->dropDup += n->le.dropDupTotal + n->le.dropDup;
+        report->ackSkipped += n->le.ackSkipped;
+        report->linksFound += n->neighbors->count;
+        if (!n->reported) {
+            continue;
+        }
+        if (n->results.m == sim.nodes[best].m && ipv6_addr_equal(&n->results.leader, &sim.nodes[best].addr)) {
+            report->correct++;
+        }
+        if (n->finishedAt - SIM_START_USEC > report->convergence) {
+            report->convergence = n->finishedAt - SIM_START_USEC;
+        }
+        conv[report->reported] = n->results.convergence;
+        rounds[report->reported] = n->results.rounds;
+        report->reported++;
+    }
+    if (report->reported > 0) {
+        qsort(conv, report->reported, sizeof(uint32_t), compareU32);
+        qsort(rounds, report->reported, sizeof(uint32_t), compareU32);
+        report->nodeConvMin = conv[0];
+        report->nodeConvMedian = conv[report->reported / 2];
+        report->nodeConvMax = conv[report->reported - 1];
+        report->roundsMedian = rounds[report->reported / 2];
+        report->roundsMax = rounds[report->reported - 1];
+    }
+    report->hellosSent = sim.hellosSent;
+    report->lastStart = (sim.lastStart > 0) ? sim.lastStart - SIM_START_USEC : 0;
+    report->framesSent = sim.framesSent;
+    report->framesReceived = sim.framesReceived;
+    report->framesLost = sim.framesLost;
+    report->framesFiltered = sim.framesFiltered;
+    report->events = sim.events;
+    free(conv);
+    free(rounds);
+}
+
+// Purpose: run one election over the configured topology
+//
+// config sim_config_t*, the topology, radio model and protocol tunables
+// report sim_report_t*, filled in with the outcome
+void sim_run(const sim_config_t *config, sim_report_t *report) {
+    struct timespec wallStart, wallEnd;
+    clock_gettime(CLOCK_MONOTONIC, &wallStart);
+
+    memset(&sim, 0, sizeof(sim));
+    memset(report, 0, sizeof(*report));
+    sim.config = config;
+    sim.numNodes = config->topo.numNodes;
+    sim.rng = config->seed;
+    sim.now = SIM_START_USEC;
+    sim.printed = UINT32_MAX;
+    sim.killed = UINT32_MAX;
+    sim.nodes = calloc(sim.numNodes, sizeof(sim_node_t));
+    if (sim.nodes == NULL) {
+        fprintf(stderr, "SIM: Error - out of memory for %"PRIu32" nodes\n", sim.numNodes);
+        exit(1);
+    }
+
+    setup();
+
+    // stop once every node has left the election, later frames change nothing;
+    // to measure a failover, that is when the leader dies instead
+    while (sim.heapLen > 0) {
+        if (sim.finished >= sim.numNodes && config->killLeader && sim.killAt == 0) {
+            sim.killAt = sim.now + config->le.hbPeriod + nextRandom() % (config->le.hbPeriod + 1);
+        }
+        if (sim.killAt == 0 ? (sim.finished >= sim.numNodes) : (sim.failedOver + 1 >= sim.numNodes)) {
+            break;
+        }
+        sim_event_t ev;
+        pop(&ev);
+        if (ev.time - SIM_START_USEC > config->limit) {
+            break;
+        }
+        if (sim.killed == UINT32_MAX && sim.killAt != 0 && ev.time >= sim.killAt) {
+            sim.killed = trueLeader();
+            sim.killedAt = sim.killAt;
+            sim.nodes[sim.killed].dead = true;
+        }
+        sim.now = ev.time;
+        sim.events++;
+        dispatch(&ev);
+    }
+
+    summarize(report);
+    clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+    report->wallSeconds = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+    for (uint32_t i = 0; i < sim.numNodes; i++) {
+        free(sim.nodes[i].neighbors);
+    }
+    free(sim.nodes);
+    free(sim.heap);
+}
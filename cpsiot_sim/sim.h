@@ -0,0 +1,133 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Discrete-event simulator for the worker's leader election.
+ *
+ * Every virtual node runs the unmodified state machine of
+ * cpsiot_workernode/protocols.c. Its timers, IPC and radio are events in one
+ * priority queue ordered by simulated time, so a run over thousands of nodes
+ * takes seconds instead of hours.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "msg.h"
+#include "xtimer.h"
+#include "net/ipv6/addr.h"
+
+#include "le_wire.h"
+#include "le_nbr.h"
+#include "le_topo.h"
+#include "le_trickle.h"
+#include "protocols.h"
+
+// simulated clock at the start message, a node's clock never reads 0
+#define SIM_START_USEC          (1000000)
+
+// gap between the unicasts of one fan-out, as in the worker's udp.c
+#define SIM_FANOUT_GAP_USEC     (10000)
+
+// run parameters
+typedef struct {
+    le_topo_t topo;             // see le_topo.h, storage allocated by main.c
+    le_config_t le;             // protocol tunables, shared by all nodes
+    bool multicast;             // one transmission per fan-out instead of paced unicasts
+    bool knownDiameter;         // nodes get the diameter with their topology
+    double loss;                // per reception, 0 to 1
+    uint32_t latency;           // usec from send to reception
+    uint32_t jitter;            // uniform extra latency, usec
+    uint32_t startSkew;         // start message arrives uniformly within this many usec
+    uint64_t limit;             // simulated usec after which a run is abandoned
+    uint64_t seed;
+    bool killLeader;            // kill the leader within a heartbeat period after all nodes finished
+    bool autonomous;            // no master, nodes find their neighbors by hellos and start by themselves
+    uint32_t helloImin;         // hello Trickle intervals, usec, as in the worker's udp.c
+    uint32_t helloImax;
+    uint32_t helloAge;          // a neighbor silent this long is dropped
+    uint32_t settle;            // neighborhood unchanged this long starts the election
+    bool verbose;               // keep the nodes' console output
+} sim_config_t;
+
+typedef struct {
+    le_state_t le;
+    le_nbr_table_t *neighbors;
+    ipv6_addr_t addr;
+    uint16_t m;
+
+    // UDP thread stand-in
+    bool running;               // start received, frames are counted
+    uint8_t fanoutFrame[LE_WIRE_MAX_LEN];
+    uint8_t fanoutLen;
+    uint16_t fanoutNext;
+    uint32_t fanoutGen;
+    uint32_t framesIn;
+    uint32_t framesOut;
+    uint32_t framesFiltered;
+
+    // autonomous discovery
+    le_trickle_t hello;
+    uint32_t helloGen;
+    uint64_t nbrChanged;        // simulated usec a neighbor last came or went
+    bool autoStarted;
+
+    // outcome
+    bool reported;              // sent its results
+    le_wire_results_t results;
+    uint64_t finishedAt;        // simulated usec of the results
+
+    // leader failure
+    bool dead;                  // killed, neither sends nor receives
+    bool failedOver;            // sent results of a re-election
+    le_wire_results_t failover; // the last of them
+} sim_node_t;
+
+typedef struct {
+    uint32_t numNodes;
+    uint32_t finished;          // nodes that left the election
+    uint32_t reported;          // nodes that elected a leader
+    uint32_t correct;           // ... and agree with the true leader
+    uint32_t trueLeader;        // smallest m, ties to the smaller address
+    uint64_t convergence;       // start to the last node's results, usec
+    uint32_t nodeConvMin;       // per node convergence as reported, usec
+    uint32_t nodeConvMedian;
+    uint32_t nodeConvMax;
+    uint32_t roundsMedian;
+    uint32_t roundsMax;
+    uint32_t killed;            // the leader that was killed, UINT32_MAX if none
+    uint64_t killedAt;          // usec after the start
+    uint32_t failedOver;        // survivors that re-elected
+    uint32_t failoverCorrect;   // ... and agree with the true leader of their part of the network
+    uint32_t parts;             // the survivors' connected parts, a cut vertex splits the network
+    uint64_t failoverNetwork;   // kill to the last survivor's results, usec
+    uint32_t failoverMin;       // per node, last heartbeat heard to the new leader, usec
+    uint32_t failoverMedian;
+    uint32_t failoverMax;
+    uint64_t hellosSent;        // autonomous discovery, included in framesSent
+    uint64_t lastStart;         // ... the last node starting its election, usec
+    uint64_t linksFound;        // neighbor table entries at the end, the topology has numLinks
+    uint64_t framesSent;        // transmissions, one per unicast or multicast
+    uint64_t framesReceived;    // receptions accepted by a UDP thread
+    uint64_t framesLost;
+    uint64_t framesFiltered;
+    uint64_t dropStale;
+    uint64_t dropDup;
+    uint64_t ackSkipped;        // round acks suppressed in stable rounds
+    uint64_t events;
+    double wallSeconds;
+} sim_report_t;
+
+// simulator core (sim.c), used by the shim
+uint64_t sim_now(void);
+kernel_pid_t sim_current_pid(void);
+void sim_timer(xtimer_t *timer, uint32_t offset, const msg_t *msg, kernel_pid_t pid);
+int sim_deliver(kernel_pid_t pid, msg_t *msg);
+uint32_t sim_random(void);
+
+void sim_run(const sim_config_t *config, sim_report_t *report);
+
+#endif /* SIM_H */
@@ -0,0 +1,119 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: The RIOT calls made by protocols.c and the IPC of ipc.h,
+ * implemented on top of the simulator's event queue.
+ */
+
+// Standard C includes
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "msg.h"
+#include "random.h"
+#include "thread.h"
+#include "xtimer.h"
+#include "net/ipv6/addr.h"
+
+#include "ipc.h"
+#include "sim.h"
+
+// the firmware's protocol thread reads the UDP thread's table, the
+// simulator hands every node its own through le_init
+le_nbr_table_t neighbors;
+
+// Purpose: current simulated time, wraps like the firmware's 32 bit clock
+uint32_t xtimer_now_usec(void) {
+    return (uint32_t)sim_now();
+}
+
+// Purpose: deliver a copy of msg to target_pid after offset usec
+void xtimer_set_msg(xtimer_t *timer, uint32_t offset, msg_t *msg, kernel_pid_t target_pid) {
+    sim_timer(timer, offset, msg, target_pid);
+}
+
+// Purpose: cancel a pending timer, its event is skipped when it comes up
+void xtimer_remove(xtimer_t *timer) {
+    timer->token = 0;
+}
+
+// Purpose: the nodes' random numbers, reproducible from the run's seed
+uint32_t random_uint32(void) {
+    return sim_random();
+}
+
+// Purpose: the protocol thread of the node whose event is processed
+kernel_pid_t thread_getpid(void) {
+    return sim_current_pid();
+}
+
+// Purpose: nodes are not threads in the simulator, the thread entry
+// points of protocols.c are never started
+kernel_pid_t thread_create(char *stack, int stacksize, uint8_t priority, int flags,
+                           thread_task_func_t function, void *arg, const char *name) {
+    (void)stack;
+    (void)stacksize;
+    (void)priority;
+    (void)flags;
+    (void)function;
+    (void)arg;
+    (void)name;
+    return KERNEL_PID_UNDEF;
+}
+
+int msg_init_queue(msg_t *array, int num) {
+    (void)array;
+    (void)num;
+    return 0;
+}
+
+int msg_receive(msg_t *m) {
+    (void)m;
+    fprintf(stderr, "SIM: Error - msg_receive called, nodes are driven by le_handle\n");
+    abort();
+}
+
+// Purpose: RIOT's address format, e.g. fe80::ff:fe00:1
+char *ipv6_addr_to_str(char *result, const ipv6_addr_t *addr, uint8_t result_len) {
+    return (char *)inet_ntop(AF_INET6, addr, result, result_len) ? result : NULL;
+}
+
+// Purpose: event blocks come from the heap, there is no pool to run dry
+ipc_event_t *ipc_alloc(void) {
+    return calloc(1, sizeof(ipc_event_t));
+}
+
+void ipc_free(ipc_event_t *event) {
+    free(event);
+}
+
+// Purpose: hand an event to another thread of the same node, processed
+// right away since simulated threads take no time
+//
+// return 1 if the event was taken, 0 if it was dropped
+int ipc_send(kernel_pid_t destinationPID, uint16_t type, ipc_event_t *event) {
+    msg_t msg_out;
+    msg_out.sender_pid = sim_current_pid();
+    msg_out.type = type;
+    msg_out.content.ptr = event;
+
+    int res = sim_deliver(destinationPID, &msg_out);
+    if (res != 1) {
+        ipc_free(event);
+    }
+    return res;
+}
+
+// Purpose: nothing queries a simulated node's leader, the answer is in its state
+int ipc_send_receive(kernel_pid_t destinationPID, uint16_t type, ipc_event_t *event) {
+    (void)destinationPID;
+    (void)type;
+    (void)event;
+    return -1;
+}
+
+int ipc_reply(msg_t *incoming) {
+    (void)incoming;
+    return 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Host checks of the ips frame layout, a neighborhood split the way
+ * the master splits it has to encode, fit LE_WIRE_MAX_LEN and decode again,
+ * with link-local and with global addresses. Run by make test.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "le_wire.h"
+
+static int failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; \
+        } \
+    } while (0)
+
+// Purpose: the address of node i, fe80::ff:fe00:i+1 or 2001:db8::i+1
+static ipv6_addr_t nodeAddr(int i, bool global) {
+    ipv6_addr_t addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.u8[0] = global ? 0x20 : 0xfe;
+    addr.u8[1] = global ? 0x01 : 0x80;
+    addr.u8[2] = global ? 0x0d : 0;
+    addr.u8[3] = global ? 0xb8 : 0;
+    addr.u8[11] = 0xff;
+    addr.u8[12] = 0xfe;
+    addr.u8[14] = (uint8_t)((i + 1) >> 8);
+    addr.u8[15] = (uint8_t)(i + 1);
+    return addr;
+}
+
+// Purpose: send a node with degree neighbors over as many frames as the
+// master would, every other link one way only if directed, and check that
+// each frame encodes, fits and decodes to what went in
+//
+// degree int, neighbors of node 0
+// global bool, use 2001:db8::/64 addresses for the neighbors
+// directed bool, make every other link one-way
+static void checkSplit(int degree, bool global, bool directed) {
+    ipv6_addr_t self = nodeAddr(0, false);
+    bool compact = le_wire_compact(&self);
+    for (int n = 1; n <= degree; n++) {
+        ipv6_addr_t addr = nodeAddr(n, global);
+        compact = compact && le_wire_compact(&addr);
+    }
+    int perFrame = compact ? LE_WIRE_IPS_MAX : LE_WIRE_IPS_FULL;
+    int parts = (degree + perFrame - 1) / perFrame;
+    int seen = 0;
+
+    for (int part = 0; part < parts; part++) {
+        uint8_t frame[LE_WIRE_MAX_LEN];
+        le_wire_ips_t ips = { .m = 42, .diameter = 3, .part = (uint8_t)part, .self = self };
+        le_wire_ips_t out;
+
+        for (int n = part * perFrame + 1; n <= degree && ips.numNeighbors < perFrame; n++) {
+            uint8_t bit = (uint8_t)(1 << ips.numNeighbors);
+            ips.neighbors[ips.numNeighbors++] = nodeAddr(n, global);
+            ips.linksIn |= bit;
+            ips.linksOut |= (directed && (n % 2)) ? 0 : bit;
+        }
+        ips.more = (part + 1 < parts);
+
+        int len = le_wire_encode_ips(frame, sizeof(frame), &ips);
+        CHECK(len > 0 && len <= LE_WIRE_MAX_LEN);
+        if (len <= 0) {
+            continue;
+        }
+        CHECK(le_wire_decode_ips(frame, (size_t)len, &out) == 0);
+        CHECK(out.m == ips.m && out.part == ips.part && out.more == ips.more);
+        CHECK(out.numNeighbors == ips.numNeighbors);
+        CHECK(out.linksIn == ips.linksIn && out.linksOut == ips.linksOut);
+        CHECK(memcmp(&out.self, &self, sizeof(self)) == 0);
+        for (int k = 0; k < out.numNeighbors && k < ips.numNeighbors; k++) {
+            CHECK(memcmp(&out.neighbors[k], &ips.neighbors[k], sizeof(ipv6_addr_t)) == 0);
+        }
+        seen += out.numNeighbors;
+    }
+    CHECK(seen == degree);
+}
+
+int main(void) {
+    for (int degree = 0; degree <= 20; degree++) {
+        checkSplit(degree, false, false);
+        checkSplit(degree, false, true);
+        checkSplit(degree, true, false);
+        checkSplit(degree, true, true);
+    }
+
+    // one full address too many per frame does not fit, and says so
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    le_wire_ips_t ips = { .m = 1, .self = nodeAddr(0, true), .numNeighbors = LE_WIRE_IPS_FULL + 1 };
+    for (int n = 0; n < ips.numNeighbors; n++) {
+        ips.neighbors[n] = nodeAddr(n + 1, true);
+    }
+    ips.linksIn = (uint8_t)((1u << ips.numNeighbors) - 1);
+    ips.linksOut = ips.linksIn;
+    CHECK(le_wire_encode_ips(frame, sizeof(frame), &ips) < 0);
+
+    printf("wire_test: %s, %d neighbors per frame link-local, %d global\n",
+           failures ? "FAILED" : "passed", LE_WIRE_IPS_MAX, LE_WIRE_IPS_FULL);
+    return failures ? 1 : 0;
+}
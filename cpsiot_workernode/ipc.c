@@ -0,0 +1,121 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Lock-free event pool and send helpers for the typed IPC in ipc.h.
+ */
+
+// Standard C includes
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Standard RIOT includes
+#include "msg.h"
+
+#include "ipc.h"
+
+#define DEBUG                   0
+
+#define IPC_POOL_MASK           ((IPC_POOL_SIZE == 32) ? UINT32_MAX : ((1UL << IPC_POOL_SIZE) - 1))
+
+// Data structures (i.e. stacks, queues, message structs, etc)
+static ipc_event_t ipc_pool[IPC_POOL_SIZE];
+static atomic_uint_least32_t ipc_pool_used = ATOMIC_VAR_INIT(0); // bit i set: block i is owned
+static atomic_uint_least32_t ipc_dropped = ATOMIC_VAR_INIT(0);
+static atomic_uint_least32_t ipc_exhausted = ATOMIC_VAR_INIT(0);
+
+// Purpose: take a block from the pool, safe from any thread
+//
+// return a zeroed event, or NULL if all blocks are in flight
+ipc_event_t *ipc_alloc(void) {
+    uint_least32_t used = atomic_load(&ipc_pool_used);
+    uint32_t free;
+    unsigned idx;
+
+    do {
+        free = ~used & IPC_POOL_MASK;
+        if (free == 0) {
+            atomic_fetch_add(&ipc_exhausted, 1);
+            if (DEBUG == 1) {
+                puts("IPC: Error - event pool exhausted");
+            }
+            return NULL;
+        }
+        idx = __builtin_ctz(free);
+    } while (!atomic_compare_exchange_weak(&ipc_pool_used, &used, used | (1UL << idx)));
+
+    memset(&ipc_pool[idx], 0, sizeof(ipc_event_t));
+    return &ipc_pool[idx];
+}
+
+// Purpose: return a block to the pool, NULL is ignored
+//
+// event ipc_event_t*, the block the caller owns
+void ipc_free(ipc_event_t *event) {
+    if (event == NULL) {
+        return;
+    }
+    unsigned idx = event - ipc_pool;
+    atomic_fetch_and(&ipc_pool_used, ~(1UL << idx));
+}
+
+// Purpose: hand an event to another thread without blocking, ownership of
+// the block passes to the receiver on success and is released on failure
+//
+// destinationPID kernel_pid_t, the destination thread ID
+// type uint16_t, the IPC event type
+// event ipc_event_t*, the payload, may be NULL for events without one
+// return 1 if the event was queued, 0 or -1 if it was dropped
+int ipc_send(kernel_pid_t destinationPID, uint16_t type, ipc_event_t *event) {
+    msg_t msg_out;
+    msg_out.type = type;
+    msg_out.content.ptr = event;
+
+    int res = msg_try_send(&msg_out, destinationPID);
+    if (res != 1) {
+        atomic_fetch_add(&ipc_dropped, 1);
+        if (DEBUG == 1) {
+            printf("IPC: dropped event 0x%04x to %" PRIkernel_pid "\n", type, destinationPID);
+        }
+        ipc_free(event);
+    }
+    return res;
+}
+
+// Purpose: send an event and block until the receiver replies with it, the
+// caller keeps ownership of the block
+//
+// destinationPID kernel_pid_t, the destination thread ID
+// type uint16_t, the IPC event type
+// event ipc_event_t*, the payload, filled in by the receiver
+int ipc_send_receive(kernel_pid_t destinationPID, uint16_t type, ipc_event_t *event) {
+    msg_t msg_out, msg_reply;
+    msg_out.type = type;
+    msg_out.content.ptr = event;
+
+    return msg_send_receive(&msg_out, &msg_reply, destinationPID);
+}
+
+// Purpose: answer an ipc_send_receive, handing the block back to its owner
+//
+// incoming msg_t*, the message to reply to
+int ipc_reply(msg_t *incoming) {
+    msg_t msg_out = *incoming;
+    return msg_reply(incoming, &msg_out);
+}
+
+// Purpose: the events lost so far, safe from any thread
+//
+// stats ipc_stats_t*, filled in
+// reset bool, start counting from zero again
+void ipc_stats(ipc_stats_t *stats, bool reset) {
+    if (reset) {
+        stats->dropped = atomic_exchange(&ipc_dropped, 0);
+        stats->exhausted = atomic_exchange(&ipc_exhausted, 0);
+    } else {
+        stats->dropped = atomic_load(&ipc_dropped);
+        stats->exhausted = atomic_load(&ipc_exhausted);
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Typed IPC between the main, UDP and protocol threads.
+ *
+ * Every event kind has its own msg_t.type. Events with a payload carry an
+ * ipc_event_t taken from a static pool in msg_t.content.ptr; ownership moves
+ * with the message and the receiver returns the block with ipc_free().
+ * Events lost to a full queue or an empty pool are counted for lestats.
+ */
+
+#ifndef IPC_H
+#define IPC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "msg.h"
+#include "net/ipv6/addr.h"
+
+#include "le_wire.h"
+
+// number of events that can be in flight at once, at most 32
+#ifndef IPC_POOL_SIZE
+#define IPC_POOL_SIZE           (16)
+#endif
+
+// msg_t.type of the IPC events, content.ptr is an ipc_event_t unless noted
+#define IPC_UDP_PID             (0x0300)  // UDP -> LE, content.value is the UDP thread PID
+#define IPC_LEADER_QUERY        (0x0301)  // main -> LE, answered with msg_reply, .leader
+#define IPC_RX_IPS              (0x0310)  // UDP -> LE, .ips
+#define IPC_RX_START            (0x0311)  // UDP -> LE, .start
+#define IPC_RX_QUERY            (0x0312)  // UDP -> LE, .query from .src
+#define IPC_RX_ACK              (0x0313)  // UDP -> LE, .ack from .src
+#define IPC_RX_DONE             (0x0314)  // UDP -> LE, .done from .src
+#define IPC_RX_RESET            (0x0315)  // UDP -> LE, .reset, back to setup for another run
+#define IPC_RX_HB               (0x0316)  // UDP -> LE, .hb from .src
+#define IPC_TX_QUERY            (0x0320)  // LE -> UDP, .query for all neighbors
+#define IPC_TX_ACK              (0x0321)  // LE -> UDP, .ack for all neighbors
+#define IPC_TX_RESULTS          (0x0322)  // LE -> UDP, .results for the master
+#define IPC_TX_DONE             (0x0323)  // LE -> UDP, .done for all neighbors
+#define IPC_TX_HB               (0x0324)  // LE -> UDP, .hb for all neighbors
+
+// events in this range hand their block (or NULL) over to the receiver
+#define IPC_OWNS_EVENT(type)    ((type) >= IPC_RX_IPS && (type) <= IPC_TX_HB)
+
+typedef struct {
+    uint16_t m;
+    ipv6_addr_t leader;
+    bool elected;
+} ipc_leader_t;
+
+typedef struct {
+    ipv6_addr_t src;    // node a received frame came from
+    union {
+        le_wire_start_t start;
+        le_wire_query_t query;
+        le_wire_ack_t ack;
+        le_wire_ips_t ips;
+        le_wire_results_t results;
+        le_wire_done_t done;
+        le_wire_reset_t reset;
+        le_wire_hb_t hb;
+        ipc_leader_t leader;
+    };
+} ipc_event_t;
+
+// events lost since the counters were last taken with reset
+typedef struct {
+    uint32_t dropped;       // msg_try_send found the receiver's queue full
+    uint32_t exhausted;     // ipc_alloc found every block in flight
+} ipc_stats_t;
+
+ipc_event_t *ipc_alloc(void);
+void ipc_free(ipc_event_t *event);
+int ipc_send(kernel_pid_t destinationPID, uint16_t type, ipc_event_t *event);
+int ipc_send_receive(kernel_pid_t destinationPID, uint16_t type, ipc_event_t *event);
+int ipc_reply(msg_t *incoming);
+void ipc_stats(ipc_stats_t *stats, bool reset);
+
+#endif /* IPC_H */
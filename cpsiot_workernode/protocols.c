@@ -15,537 +15,1100 @@
 #include <msg.h>
 
 // Standard RIOT includes
+#include "random.h"
 #include "thread.h"
 #include "xtimer.h"
 
+// Networking includes
+#include "net/ipv6/addr.h"
+
+// Shared includes
+#include "le_wire.h"
+#include "le_nbr.h"
+#include "ipc.h"
+#include "protocols.h"
+#include "trace.h"
+
 #define CHANNEL                 11
 
 #define MAIN_QUEUE_SIZE         (32)
-#define MAX_IPC_MESSAGE_SIZE    (128)
 #define IPV6_ADDRESS_LEN        (46)
-#define MAX_NEIGHBORS           (8)
 
 #define DEBUG                   0
 
 // Leader Election values
+#ifndef K
 #define K     (5)
+#endif
+#ifndef T1
 #define T1    (6*1000000)
+#endif
+#ifndef T2
 #define T2    (4*1000000)
-
-// External functions defs
-extern int ipc_msg_send(char *message, kernel_pid_t destinationPID, bool blocking);
-extern int ipc_msg_reply(char *message, msg_t incoming);
-extern int ipc_msg_send_receive(char *message, kernel_pid_t destinationPID, msg_t *response, uint16_t type);
-extern void substr(char *s, int a, int b, char *t);
-extern int indexOfSemi(char *ipv6);
-extern void extractIP(char **s, char *t);
+#endif
+
+// bounds of the adaptive round timeout in usec, T1/T2 are only used until
+// the first neighbor response times are known
+#ifndef LE_RTO_MIN
+#define LE_RTO_MIN              (200000)
+#endif
+#ifndef LE_RTO_MAX
+#define LE_RTO_MAX              (T1)
+#endif
+
+// termination rule, see protocols.h
+#ifndef LE_TERMINATION
+#define LE_TERMINATION          LE_TERMINATION_DIAMETER
+#endif
+#ifndef LE_EPSILON
+#define LE_EPSILON              (1)
+#endif
+
+// leader heartbeats after the election, see protocols.h
+#ifndef LE_HB_PERIOD_USEC
+#define LE_HB_PERIOD_USEC       (5000000)
+#endif
+#ifndef LE_HB_TIMEOUT_USEC
+#define LE_HB_TIMEOUT_USEC      (3 * LE_HB_PERIOD_USEC)
+#endif
+#ifndef LE_HB_REDUNDANCY
+#define LE_HB_REDUNDANCY        (2)
+#endif
+
+// round ack suppression, see protocols.h
+#ifndef LE_ACK_REDUNDANCY
+#define LE_ACK_REDUNDANCY       (2)
+#endif
+#ifndef LE_ACK_QUIET_MAX
+#define LE_ACK_QUIET_MAX        (3)
+#endif
+
+// IPC message types of the protocol thread's own deadline and heartbeat
+// timers, kept apart from the IPC event types in ipc.h
+#define LE_TIMER_MSG_TYPE       (0x0100)
+#define LE_HB_MSG_TYPE          (0x0101)
 
 // Forward declarations
 kernel_pid_t leader_election(int argc, char **argv);
 void *_leader_election(void *argv);
-void substr(char *s, int a, int b, char *t);
 
 // Data structures (i.e. stacks, queues, message structs, etc)
 static char protocol_stack[THREAD_STACKSIZE_DEFAULT];
 static msg_t _protocol_msg_queue[MAIN_QUEUE_SIZE];
 static msg_t msg_p_in;//, msg_out;
+static le_config_t le_config;
+static le_state_t le_state;
 
-kernel_pid_t udpServerPID = 0;
+// neighbor table, filled by the UDP thread before it forwards the ips event,
+// the per-neighbor round state is only touched by this thread
+extern le_nbr_table_t neighbors;
 
-// Purpose: determine if an ipv6 address is already registered
+// Purpose: use ipv6 addresses to break ties
 //
-// neighbors char**, list of registered neighbors
-// ipv6 char*, the address to check for
-int alreadyANeighbor(char **neighbors, char *ipv6) {
-    for(int i = 0; i < MAX_NEIGHBORS; i++) {
-        if(strcmp(neighbors[i], ipv6) == 0) return 1;
+// ipv6_a ipv6_addr_t*, the first ipv6 address
+// ipv6_b ipv6_addr_t*, the second ipv6 address
+// return -1 if a<b, 1 if a>b, 0 if a==b
+int minIPv6(const ipv6_addr_t *ipv6_a, const ipv6_addr_t *ipv6_b) {
+    int res = memcmp(ipv6_a->u8, ipv6_b->u8, sizeof(ipv6_addr_t));
+    return (res < 0) ? -1 : (res > 0);
+}
+
+// Purpose: rounds without a change to min after which the election ends
+//
+// le le_state_t*, the node, for its config, diameter and span
+static int stableTarget(const le_state_t *le) {
+    int k = le->config->k;
+    if (le->config->termination == LE_TERMINATION_DIAMETER) {
+        if (le->diameter > 0) {
+            return le->diameter + le->config->epsilon;
+        }
+        // twice the largest leader distance heard so far, the stable count
+        // restarts whenever it grows (endRound); never below the K rule
+        int learned = 2 * le->span + le->config->epsilon;
+        return (learned > k + 1) ? learned : k + 1;
     }
-    return 0;
+    return k + 1; // counting K down to 0 and finishing on the next round
 }
 
-// Purpose: retrieve the internal index of an address
+// Purpose: whether the current round ends the election if min stays the same;
+// without a diameter, a longer path heard of may still carry a smaller m, and
+// a node still missing the minimum in round r has heard of leader distances
+// with r <= 2*span + 3*hops (one hop per round), so the round must pass that
 //
-// neighbors char**, list of registered neighbors
-// ipv6 char*, ipv6 to check for
-int getNeighborIndex(char **neighbors, char *ipv6) {
-    for(int i = 0; i < MAX_NEIGHBORS; i++) {
-        if(strcmp(neighbors[i], ipv6) == 0) return i;
+// le le_state_t*, the node
+// return true if a round without news is the last one
+static bool lastRound(const le_state_t *le) {
+    bool learned = le->config->termination == LE_TERMINATION_DIAMETER && le->diameter == 0;
+    bool settled = !learned || (le->span == le->roundSpan &&
+                                le->round > 2 * le->span + 3 * le->hops + 2 + le->config->epsilon);
+    return le->stable + 1 >= le->target && settled;
+}
+
+// Purpose: hand an le_ack frame with our current view to the UDP thread
+//
+// le le_state_t*, the node whose round, min, hops, span and leader are sent
+static void sendAck(const le_state_t *le) {
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
     }
-    return -1;
+
+    event->ack.epoch = le->epoch;
+    event->ack.term = le->term;
+    event->ack.round = le->round;
+    event->ack.m = (uint16_t)le->min;
+    event->ack.hops = le->hops;
+    event->ack.span = le->span;
+    event->ack.quiet = (le->ackNext > le->round + 1) ? (uint8_t)(le->ackNext - le->round - 1) : 0;
+    event->ack.leader = le->leader;
+    event->ack.sender = le->myIPv6;
+    ipc_send(le->udpServerPID, IPC_TX_ACK, event);
 }
 
-// Purpose: use ipv6 addresses to break ties 
+// Purpose: ask every neighbor for its current m value, each answers with an ack
 //
-// ipv6_a char*, the first ipv6 address
-// ipv6_b char*, the second ipv6 address
-// return -1 if a<b, 1 if a>b, 0 if a==b
-int minIPv6(char *ipv6_a, char *ipv6_b) {
-    uint32_t minLength = strlen(ipv6_a);
-    if (strlen(ipv6_b) < minLength) minLength = strlen(ipv6_b);
-    
-    for (uint32_t i = 0; i < minLength; i++) {
-        if (ipv6_a[i] < ipv6_b[i]) {
-            return -1;
-        } else if (ipv6_b[i] < ipv6_a[i]) {
-            return 1;
+// le le_state_t*, the node, at the start of the election or a round
+static void sendQuery(const le_state_t *le) {
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
+    }
+
+    event->query.epoch = le->epoch;
+    event->query.round = le->round;
+    ipc_send(le->udpServerPID, IPC_TX_QUERY, event);
+}
+
+// Purpose: start or pass on the completion wave, each node floods it once
+//
+// le le_state_t*, the node with the elected m value and leader
+static void sendDone(const le_state_t *le) {
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
+    }
+
+    event->done.epoch = le->epoch;
+    event->done.term = le->term;
+    event->done.m = (uint16_t)le->min;
+    event->done.leader = le->leader;
+    ipc_send(le->udpServerPID, IPC_TX_DONE, event);
+}
+
+// Purpose: hand a heartbeat of our leader to the UDP thread, the leader
+// starts each one, the others pass it on
+//
+// le le_state_t*, the node with the leader, term and heartbeat sequence number
+static void sendHeartbeat(const le_state_t *le) {
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
+    }
+
+    event->hb.epoch = le->epoch;
+    event->hb.term = le->term;
+    event->hb.seq = le->hbSeq;
+    event->hb.m = (uint16_t)le->min;
+    event->hb.leader = le->leader;
+    ipc_send(le->udpServerPID, IPC_TX_HB, event);
+}
+
+// Purpose: best value among the neighbors that already reported this round,
+// using the same rule as incoming acks (the smaller m wins, between equal ones
+// the smaller leader address, as in the tie rule of endRound)
+//
+// le le_state_t*, the node, tempLeader and tempHops are set to the owner of
+//    the returned m and the shortest reported distance to it
+// return the smallest m, 257 if no neighbor has reported
+static uint32_t bestReported(le_state_t *le) {
+    uint32_t best = 257;
+    for (uint16_t i = 0; i < le->neighbors->count; i++) {
+        le_nbr_t *nbr = &le->neighbors->entries[i];
+        if (nbr->m == 0) {
+            continue;
+        }
+        if (nbr->m < best || (nbr->m == best && minIPv6(&nbr->leader, &le->tempLeader) < 0)) {
+            best = nbr->m;
+            le->tempLeader = nbr->leader;
+            le->tempHops = nbr->hops;
+        } else if (nbr->m == best && ipv6_addr_equal(&le->tempLeader, &nbr->leader) && nbr->hops < le->tempHops) {
+            le->tempHops = nbr->hops;
         }
     }
-    return 0;
+    return best;
 }
 
-// ************************************
-// START MY CUSTOM THREAD DEFS
+// Purpose: answer a leader query from the shell, the block stays with the caller
+//
+// le le_state_t*, the node
+// incoming msg_t*, the IPC_LEADER_QUERY message
+static void replyLeader(const le_state_t *le, msg_t *incoming) {
+    ipc_event_t *event = (ipc_event_t *)incoming->content.ptr;
+    event->leader.m = (uint16_t)le->min;
+    event->leader.leader = le->leader;
+    event->leader.elected = le->hasElectedLeader;
+    ipc_reply(incoming);
+}
 
-// Purpose: launch the procotol thread
+// Purpose: arm the protocol deadline timer, replacing any pending deadline
 //
-// argc int, argument count (should be 2)
-// argv char**, list of arguments ("leader_election",<port>)
-kernel_pid_t leader_election(int argc, char **argv) {
-    if (argc != 2) {
-        puts("Usage: leader_election <port>");
-        return 0;
+// le le_state_t*, the node that owns the timer
+// offset uint32_t, microseconds from now until the timer message is delivered
+// return the generation id carried by the timer message
+static uint32_t setDeadline(le_state_t *le, uint32_t offset) {
+    xtimer_remove(&le->timer);
+    le->timerMsg.type = LE_TIMER_MSG_TYPE;
+    le->timerMsg.content.value += 1; // older expiries still queued become stale
+    xtimer_set_msg(&le->timer, offset, &le->timerMsg, thread_getpid());
+    return le->timerMsg.content.value;
+}
+
+// Purpose: enter a phase of the node, traced with the term; the neighbor
+// table is pinned while the election runs
+//
+// le le_state_t*, the node
+// phase le_phase_t, the new phase
+static void setPhase(le_state_t *le, le_phase_t phase) {
+    le->phase = phase;
+    le->neighbors->pinned = (phase == LE_PHASE_ELECTION);
+    TRACE(TRACE_PHASE, phase, le->term);
+}
+
+// Purpose: enter a state of the election's state machine, traced with the round
+//
+// le le_state_t*, the node
+// state int, the new stateLE
+static void setState(le_state_t *le, int state) {
+    le->stateLE = state;
+    TRACE(TRACE_STATE, state, le->round);
+}
+
+// Purpose: fill in the defaults from the Makefile
+//
+// config le_config_t*, the configuration to set
+void le_config_default(le_config_t *config) {
+    config->k = K;
+    config->t1 = T1;
+    config->t2 = T2;
+    config->rtoMin = LE_RTO_MIN;
+    config->rtoMax = LE_RTO_MAX;
+    config->termination = LE_TERMINATION;
+    config->epsilon = LE_EPSILON;
+    config->hbPeriod = LE_HB_PERIOD_USEC;
+    config->hbTimeout = LE_HB_TIMEOUT_USEC;
+    config->hbRedundancy = LE_HB_REDUNDANCY;
+    config->ackRedundancy = LE_ACK_REDUNDANCY;
+    config->ackQuietMax = LE_ACK_QUIET_MAX;
+}
+
+// Purpose: reset a node to wait for its topology
+//
+// le le_state_t*, the node
+// config le_config_t*, its tunables, must outlive the node
+// neighbors le_nbr_table_t*, its neighbor table
+void le_init(le_state_t *le, const le_config_t *config, le_nbr_table_t *neighbors) {
+    memset(le, 0, sizeof(*le));
+    le->config = config;
+    le->neighbors = neighbors;
+    setPhase(le, LE_PHASE_SETUP);
+    le->m = 257;
+    le->min = le->m;
+    le->tempMin = 257;
+    le->target = config->k + 1;
+    le->t1 = config->t1;
+    le->t2 = config->t2;
+    strcpy(le->leaderStr, "unknown");
+}
+
+// Purpose: back to the state before the start message, for another run over
+// the same topology with a new m value
+//
+// le le_state_t*, the node
+// m uint32_t, its m value for the next run
+void le_reset(le_state_t *le, uint32_t m) {
+    xtimer_remove(&le->timer);
+    xtimer_remove(&le->hbTimer);
+    le_state_t kept = *le;
+
+    le_init(le, kept.config, kept.neighbors);
+    le_nbr_reset_run(le->neighbors, false);
+    le->udpServerPID = kept.udpServerPID;
+    le->epoch = kept.epoch;
+    le->timerMsg.content.value = kept.timerMsg.content.value; // expiries still queued stay stale
+    le->myIPv6 = kept.myIPv6;
+    le->diameter = kept.diameter;
+    le->topoComplete = kept.topoComplete;
+    le->allowLE = kept.topoComplete;
+    le->m = m;
+    le->min = m;
+    le->leader = le->myIPv6;
+    ipv6_addr_to_str(le->leaderStr, &le->leader, IPV6_ADDRESS_LEN);
+    printf("LE: reset for another run, m=%"PRIu32"\n", le->m);
+}
+
+// Purpose: the election is over (or could not run), report to the master
+// and from now on only answer late queries
+//
+// le le_state_t*, the node
+static void finishElection(le_state_t *le) {
+    xtimer_remove(&le->timer);
+    le->deadline = 0;
+    setPhase(le, LE_PHASE_FINISHED);
+    le->ackNext = 0; // late queries get acks that announce nothing
+    if (DEBUG == 1) {
+        printf("LE: quit main loop\n");
+    }
+    // if the master node needs information from this protocol thread
+    // send IPC messages to the UDP thread to forward to the master node
+    // (the UDP thread fills in the message count)
+
+    if (le->hasElectedLeader) {
+        ipc_event_t *results = ipc_alloc();
+        if (results != NULL) {
+            results->results.epoch = le->epoch;
+            results->results.m = (uint16_t)le->min;
+            results->results.leader = le->leader;
+            results->results.convergence = le->convergenceTimeLE;
+            results->results.rounds = le->round;
+            // our clock, the UDP thread converts both to the master's
+            results->results.started = le->startTimeLE;
+            results->results.ended = le->startTimeLE + le->convergenceTimeLE;
+            results->results.term = le->term;
+            results->results.failover = le->failoverTime;
+            if (DEBUG == 1) {
+                printf("LE: sending results: %s;%"PRIu32"\n", le->leaderStr, le->convergenceTimeLE);
+            }
+            ipc_send(le->udpServerPID, IPC_TX_RESULTS, results);
+        }
     }
 
-    kernel_pid_t protocolPID = thread_create(protocol_stack, sizeof(protocol_stack), THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST, _leader_election, argv[1], "Protocol_Thread");
+    if (le->hasElectedLeader && le->config->hbPeriod > 0) {
+        // the leader starts heartbeating, everyone else starts waiting for them
+        le->hbSeq = 0;
+        le->hbHeard = 0;
+        le->hbLast = xtimer_now_usec();
+        if (ipv6_addr_equal(&le->leader, &le->myIPv6)) {
+            le->deadline = setDeadline(le, le->config->hbPeriod);
+        } else {
+            le->deadline = setDeadline(le, le->config->hbTimeout);
+        }
+    }
+}
 
-    printf("MAIN: thread_create(..., protocol_thread) returned: %" PRIkernel_pid "\n", protocolPID);
-    if (protocolPID <= KERNEL_PID_UNDEF) {
-        (void) puts("MAIN: Error - failed to start leader election thread");
-        return 0;
+// Purpose: the leader is gone, elect a new one among the nodes that are left
+// without starting over: response times, span and diameter stay, the old
+// leader's m is forgotten and everyone starts from their own m again
+//
+// le le_state_t*, the node
+// term uint8_t, the term of the re-election
+// round uint16_t, round to join, that of the ack that told us about the term
+static void reelect(le_state_t *le, uint8_t term, uint16_t round) {
+    printf("LE: re-electing in term %u, the leader was %s\n", term, le->leaderStr);
+    xtimer_remove(&le->hbTimer);
+    bool following = le->hasElectedLeader && !ipv6_addr_equal(&le->leader, &le->myIPv6);
+    le->failoverStart = following ? le->hbLast : xtimer_now_usec();
+    le->failoverTime = 0;
+    le->term = term;
+    setPhase(le, LE_PHASE_ELECTION);
+    le->hasElectedLeader = false;
+    le->startTimeLE = xtimer_now_usec();
+
+    le->min = le->m;
+    le->leader = le->myIPv6;
+    ipv6_addr_to_str(le->leaderStr, &le->leader, IPV6_ADDRESS_LEN);
+    le->tempMin = 257;
+    le->hops = 0;
+    le->stable = 0;
+    le->target = stableTarget(le);
+    le->round = round;
+    le_nbr_reset_run(le->neighbors, true);
+    le->countedMs = 0;
+    le->impliedMs = 0;
+    le->impliedAsked = false;
+    le->ackQuiet = 0;
+    le->ackNext = 0;
+    le->ackHeard = 0;
+
+    // announce the term, then run the rounds on the adaptive timeout right away
+    sendAck(le);
+    le->askedAt = xtimer_now_usec();
+    le->lastT1 = 0;
+    setState(le, 2);
+    le->deadline = setDeadline(le, 0);
+}
+
+// Purpose: a heartbeat of our leader arrived, re-arm the failure deadline and
+// pass it on after a random delay, unless enough neighbors did so first
+//
+// le le_state_t*, the node
+// hb le_wire_hb_t*, the decoded heartbeat
+static void handleHeartbeat(le_state_t *le, const le_wire_hb_t *hb) {
+    if (hb->epoch != le->epoch || hb->term != le->term || !ipv6_addr_equal(&hb->leader, &le->leader) ||
+        ipv6_addr_equal(&le->leader, &le->myIPv6)) {
+        return; // not our leader's, or our own coming back
+    }
+    if ((int16_t)(hb->seq - le->hbSeq) > 0) {
+        le->hbSeq = hb->seq;
+        le->hbHeard = 1;
+        le->hbLast = xtimer_now_usec();
+        le->deadline = setDeadline(le, le->config->hbTimeout);
+
+        // listen for a quarter of the period before deciding whether to pass it on
+        le->hbMsg.type = LE_HB_MSG_TYPE;
+        le->hbMsg.content.value = hb->seq;
+        xtimer_set_msg(&le->hbTimer, random_uint32() % (le->config->hbPeriod / 4 + 1), &le->hbMsg, thread_getpid());
+    } else if (hb->seq == le->hbSeq && le->hbHeard < UINT8_MAX) {
+        le->hbHeard++;
     }
+}
 
-    return protocolPID;
+// Purpose: the start message arrived, set up the rounds and query the neighbors
+//
+// le le_state_t*, the node
+static void startElection(le_state_t *le) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    int numNeighbors = le->neighbors->count;
+    static const char *links[] = { "", " (in)", " (out)", "" };
+
+    // thread startup complete
+    printf("Topology assignment complete, %d neighbors:\n",numNeighbors);
+    for (int i = 0; i < numNeighbors; i++) {
+        printf("%2d: %s%s\n", i + 1, ipv6_addr_to_str(ipv6, &le->neighbors->entries[i].addr, IPV6_ADDRESS_LEN),
+               links[le->neighbors->entries[i].link & LE_NBR_BOTH]);
+    }
+
+    // leader election, check if it's time to run, then initialize
+    if (numNeighbors == 0 || le->hasElectedLeader || !le->allowLE) {
+        finishElection(le);
+        return;
+    }
+    (void) puts("LE: Starting leader election...");
+    setPhase(le, LE_PHASE_ELECTION);
+    le->allowLE = false;
+    le->startTimeLE = xtimer_now_usec();
+    le->stable = 0;
+    le->target = stableTarget(le);
+    printf("LE: terminating after %d stable rounds (diameter %u)\n", le->target, le->diameter);
+
+    // case 0: send out multicast ping, does not wait on any event
+    if (DEBUG == 1) {
+        printf("LE: case 0, leader=%s, min=%"PRIu32"\n", le->leaderStr, le->min);
+    }
+    sendQuery(le);
+    le->askedAt = xtimer_now_usec();
+    setState(le, 1);
+    le->countedMs = 0;
+    le->deadline = setDeadline(le, le->t2);
 }
 
-// Purpose: the actual protocol thread code
-// Currently implements neighbor discovery and leader election
+// Purpose: before the election, collect the UDP thread's PID, the topology
+// and finally the start message
 //
-// argv void*, exists for RIOT semantics purposes (unused)
-void *_leader_election(void *argv) {
-    (void)argv;
-    msg_init_queue(_protocol_msg_queue, MAIN_QUEUE_SIZE);
+// le le_state_t*, the node
+// msg msg_t*, the message
+// event ipc_event_t*, its event block, NULL for untyped messages
+static void handleSetup(le_state_t *le, msg_t *msg, ipc_event_t *event) {
+    if (msg->type == IPC_UDP_PID) { // process UDP server PID
+
+        le->udpServerPID = (kernel_pid_t)msg->content.value;
+        if (DEBUG == 1) {
+            printf("LE: Protocol thread recorded %" PRIkernel_pid " as the UDP server thread's PID\n", le->udpServerPID);
+        }
+
+    } else if (msg->type == IPC_LEADER_QUERY) { // report about the leader
+
+        if (DEBUG == 1) {
+            printf("LE: replying with leader=%s\n", le->leaderStr);
+        }
+        replyLeader(le, msg);
+
+    } else if (msg->type == IPC_RX_IPS) { // react to input, allowed anytime
+
+        if (!le->topoComplete) {
+            le->m = event->ips.m;
+            le->min = le->m;
+            le->diameter = event->ips.diameter;
+            printf("LE: Protocol thread recorded %"PRIu32" as it's m value\n", le->m);
+
+            le->myIPv6 = event->ips.self;
+            le->leader = le->myIPv6;
+            ipv6_addr_to_str(le->leaderStr, &le->leader, IPV6_ADDRESS_LEN);
+            printf("LE: Protocol thread recorded %s as it's IPv6\n", le->leaderStr);
+            le->allowLE = true;
+
+            // the UDP thread already recorded the neighbors, wait for the last frame
+            le->topoComplete = !event->ips.more;
+        }
 
-    char msg_content[MAX_IPC_MESSAGE_SIZE];
+    } else if (msg->type == IPC_RX_START) {
+
+        le->epoch = event->start.epoch;
+        le->term = 0;
+        startElection(le);
+
+    } else if (msg->type == LE_TIMER_MSG_TYPE || msg->type == LE_HB_MSG_TYPE) {
+
+        // queued before a reset, nothing to do
+
+    } else if (!IPC_OWNS_EVENT(msg->type)) {
+
+        printf("LE: Protocol thread received an illegal IPC message, type=0x%04x\n", msg->type);
+
+    }
+}
 
-    // ipv6 address vars
+// Purpose: a neighbor has responded with its min, the owner of it and itself
+//
+// le le_state_t*, the node
+// ack le_wire_ack_t*, the decoded le_ack
+static void handleAck(le_state_t *le, const le_wire_ack_t *ack) {
     char ipv6[IPV6_ADDRESS_LEN] = { 0 };
     char ipv6_2[IPV6_ADDRESS_LEN] = { 0 };
-    char myIPv6[IPV6_ADDRESS_LEN] = { 0 };
-    char initLE[8] = "le_init";
-    char neighborM[4] = { 0 };
-
-    uint32_t startTimeLE = 0;
-    uint32_t endTimeLE = 0;
-    uint32_t convergenceTimeLE = 0;
-    bool hasElectedLeader = false;
-    bool runningLE = false;
-    bool allowLE = false;
-    int stateLE = 0;
-    int countedMs = 0;
-    bool quit = false;
-
-    // Ali's LE variables
-    int counter = K; //k
-    uint32_t m; // my leader election value, range 1 to 255
-    uint32_t min;                       // the min of my neighborhood 
-    uint32_t tempMin = 257;
-    char leader[IPV6_ADDRESS_LEN] = "unknown";    // the "leader so far"
-    char tempLeader[IPV6_ADDRESS_LEN];    // temp leader for a round of communication
-    uint32_t t1 = T1;
-    uint32_t t2 = T2;
-    uint32_t lastT1 = 0;
-    uint32_t lastT2 = 0;
-    bool topoComplete = false;
-
-    int res = 0;
-
-    // array of MAX neighbors
-    int c = 0; // other counter
-    int i = 0; // loop counter
-    int numNeighbors = 0;
-    uint32_t neighborsVal[MAX_NEIGHBORS] = { 0 }; 
-    char **neighbors = (char**)calloc(MAX_NEIGHBORS, sizeof(char*));
-    for(i = 0; i < MAX_NEIGHBORS; i++) {
-        neighbors[i] = (char*)calloc(IPV6_ADDRESS_LEN, sizeof(char));
-    }
-
-    m = 257;
-    min = m;
-
-    printf("LE: Success - started protocol thread with m=%"PRIu32"\n", m);
-
-    // main thread startup loop
-    while (1) { 
-        if (quit) break;
-        // process messages
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        res = msg_try_receive(&msg_p_in);
-        //printf("LE: after msg_try_receive, code=%d\n", res);
-        if (res == 1) {
-            if (msg_p_in.type == 0 && udpServerPID == (kernel_pid_t)0) { // process UDP server PID
-
-                //(void) puts("LE: in type==0 block");
-                udpServerPID = *(kernel_pid_t*)msg_p_in.content.ptr;
-                if (DEBUG == 1) {
-                    printf("LE: Protocol thread recorded %" PRIkernel_pid " as the UDP server thread's PID\n", udpServerPID);
-                }
-                continue;
-
-            } else if (msg_p_in.type == 1) { // receive m value
-
-                if (DEBUG == 1) {
-                    printf("LE: in type==1 block, content=%s\n", (char*)msg_p_in.content.ptr);
-                }
-                m = atoi((char*)msg_p_in.content.ptr);
-                min = m;
-                continue;
-
-            } else if (msg_p_in.type == 2) { // report about the leader
-
-                if (DEBUG == 1) {
-                    printf("LE: in type==2 block, content=%s\n", (char*)msg_p_in.content.ptr);
-                    printf("LE: replying with msg=%s, size=%u\n", leader, strlen(leader));
-                }
-                ipc_msg_reply(leader, msg_p_in);
-                continue;
-
-            } else if (msg_p_in.type > 2 && msg_p_in.type < MAX_IPC_MESSAGE_SIZE) { // process string message of size msg_p_in.type
-
-                //printf("LE: in type>2 block, type=%u\n", (uint16_t)msg_p_in.type);
-                strncpy(msg_content, (char*)msg_p_in.content.ptr, (uint16_t)msg_p_in.type+1);
-                if (DEBUG == 1) {
-                    printf("LE: Protocol thread received IPC message: %s from PID=%" PRIkernel_pid " with type=%d\n", msg_content, msg_p_in.sender_pid, msg_p_in.type);
-                }
-
-            } else {
-
-                (void) puts("LE: Protocol thread received an illegal or too large IPC message");
-                continue;
+    int i = le_nbr_find(le->neighbors, &ack->sender);
+
+    if (ack->m == 0 || i < 0 || !(le->neighbors->entries[i].link & LE_NBR_IN)) {
+        return;
+    }
+    le_nbr_t *nbr = &le->neighbors->entries[i];
+
+    bool news = ack->epoch == le->epoch && ack->term == le->term &&
+                (ack->m < le->min || (ack->m == le->min && minIPv6(&ack->leader, &le->leader) < 0));
+    uint8_t quiet = le->impliedAsked ? 1 : ack->quiet;
+    if (!news && (ack->epoch != le->epoch || ack->term != le->term || ack->round + quiet < le->round)) {
+        // left over from an earlier run, term or round, it would end this round without new information;
+        // an ack whose quiet stretch reaches this round still stands for it, after our query only one from
+        // this round or the one before, and a better leader from a neighbor we ran ahead of on its implied
+        // reports counts right away
+        le->dropStale++;
+        return;
+    }
+    if (nbr->m != 0 && ack->round <= nbr->round) {
+        // this neighbor already reported for this round
+        le->dropDup++;
+        return;
+    }
+
+    ipv6_addr_to_str(ipv6, &ack->leader, IPV6_ADDRESS_LEN); // owner ID
+    printf("LE: m value %d received from %s, owner %s\n", ack->m,
+           ipv6_addr_to_str(ipv6_2, &ack->sender, IPV6_ADDRESS_LEN), ipv6);
+    if (nbr->implied) {
+        // it spoke after all, the ack replaces the one standing in
+        nbr->implied = false;
+        nbr->m = 0;
+        le->impliedMs--;
+    }
+    if (nbr->m == 0) {
+        le->countedMs++;
+        // first answer for our query or round, feeds the timeout estimate
+        if (ack->round == le->round) {
+            le_nbr_rtt_sample(nbr, xtimer_now_usec() - le->askedAt);
+        }
+    }
+    nbr->m = ack->m;
+    nbr->round = ack->round;
+    nbr->leader = ack->leader;
+    nbr->hops = ack->hops;
+    nbr->quietUntil = ack->round + ack->quiet;
+    if (ack->m == le->min && ipv6_addr_equal(&ack->leader, &le->leader)) {
+        le->ackHeard++;
+    } else {
+        le->ackReset = true; // it sees a different leader, it needs to hear ours
+    }
+    if (ack->span > le->span) {
+        le->span = ack->span;
+    }
+    if (nbr->m == le->tempMin && ipv6_addr_equal(&ack->leader, &le->tempLeader) && ack->hops < le->tempHops) {
+        le->tempHops = ack->hops;
+    }
+    if (nbr->m < le->tempMin || (nbr->m == le->tempMin && minIPv6(&ack->leader, &le->tempLeader) < 0)) {
+        // equal m values are a tie the smaller address wins, whichever neighbor reports first
+        le->tempLeader = ack->leader;
+        le->tempMin = nbr->m;
+        le->tempHops = ack->hops;
+        printf("LE: new tempMin=%"PRIu32", tempLeader=%s\n", le->tempMin, ipv6);
+    }
+}
 
+// Purpose: Trickle for the round acks, decide whether the round that just
+// started gets ours; an ack announces how many rounds we skip after it,
+// twice as many as before if the last round brought ackRedundancy
+// consistent reports, none after an inconsistency
+//
+// le le_state_t*, the node, at the start of its round
+// return true to skip the ack this round
+static bool skipAck(le_state_t *le) {
+    uint8_t k = le->config->ackRedundancy;
+    uint8_t heard = le->ackHeard;
+    bool reset = le->ackReset || le->stable == 0 || k == 0;
+
+    le->ackHeard = 0;
+    le->ackReset = false;
+    if (reset) {
+        le->ackQuiet = 0;
+    } else if (le->round < le->ackNext) {
+        return true;
+    } else if (heard >= k) {
+        uint16_t quiet = 2 * le->ackQuiet + 1;
+        le->ackQuiet = (quiet > le->config->ackQuietMax) ? le->config->ackQuietMax : quiet;
+    }
+    le->ackNext = le->round + le->ackQuiet + 1;
+    return false;
+}
+
+// Purpose: the quiet neighbors' acks stand in for this round, they count
+// once the slowest neighbor would usually have answered; a neighbor that
+// has been quiet all along has no response time of its own
+//
+// le le_state_t*, the node, at the start of its round
+static void impliedStart(le_state_t *le) {
+    bool sampled = false;
+
+    le->impliedDue = 0;
+    if (le->impliedMs == 0) {
+        return;
+    }
+    for (uint16_t i = 0; i < le->neighbors->count; i++) {
+        le_nbr_t *nbr = &le->neighbors->entries[i];
+        if (nbr->rttSamples > 0) {
+            sampled = true;
+            if (nbr->srtt > le->impliedDue) {
+                le->impliedDue = nbr->srtt;
             }
         }
+        if (nbr->implied && nbr->m == le->min && ipv6_addr_equal(&nbr->leader, &le->leader)) {
+            le->ackHeard++;
+        }
+    }
+    if (!sampled || le->impliedDue > le->t2) {
+        le->impliedDue = le->t2;
+    }
+}
 
-        // react to input, allowed anytime
-        if (res == 1) {
-            if (strncmp(msg_content, "ips:", 4) == 0) {
-                if (!topoComplete) {
-                    char *msg = (char*)calloc(MAX_IPC_MESSAGE_SIZE, sizeof(char));
-                    char *mem = msg;
-                    substr(msg_content, 4, strlen(msg_content)-4, msg);
-
-                    extractIP(&msg,neighborM);
-                    m = atoi(neighborM);
-                    min = m;
-                    printf("LE: Protocol thread recorded %"PRIu32" as it's m value\n", m);
-
-                    extractIP(&msg,myIPv6);
-                    strcpy(leader, myIPv6);
-                    printf("LE: Protocol thread recorded %s as it's IPv6\n", leader);
-                    allowLE = true;
-
-                    // extract neighbors IPs from message
-                    while(strlen(msg) > 1) {
-                        extractIP(&msg,neighbors[numNeighbors]);
-                        printf("LE: Extracted neighbor %d: %s\n", numNeighbors+1, neighbors[numNeighbors]);
-                        numNeighbors++;
-                    }
-                    
-                    topoComplete = true;
-                    free(mem);
-                }
-
-            } else if (strncmp(msg_content, "start:", 6) == 0) {
-                quit = true;
-                break;
+// Purpose: the round that just started may end the election, but a quiet
+// neighbor may lag behind us with a smaller m on its way; its standing ack
+// no longer counts, the neighbors are asked for theirs instead and answers
+// from this round or the one before count
+//
+// le le_state_t*, the node, at the start of its round
+static void impliedEnd(le_state_t *le) {
+    printf("LE: round %u may be the last, asking %d quiet neighbors\n", le->round, le->impliedMs);
+    for (uint16_t i = 0; i < le->neighbors->count; i++) {
+        le->neighbors->entries[i].quietUntil = 0;
+    }
+    le->countedMs = le_nbr_reset_round(le->neighbors, le->round, &le->impliedMs);
+    le->impliedAsked = true;
+}
+
+// Purpose: whether every neighbor we hear reported this round, quiet ones
+// by their standing ack, otherwise wake up when those count
+//
+// le le_state_t*, the node
+// numNeighbors int, the reports a round waits for
+static bool roundComplete(le_state_t *le, int numNeighbors) {
+    if (le->countedMs + le->impliedMs < numNeighbors) {
+        return false;
+    }
+    uint32_t elapsed = xtimer_now_usec() - le->askedAt;
+    if (le->impliedMs == 0 || elapsed >= le->impliedDue) {
+        return true;
+    }
+    le->deadline = setDeadline(le, le->impliedDue - elapsed);
+    return false;
+}
+
+// Purpose: close a round, lines 5a-f and 6 of pseudocode
+//
+// le le_state_t*, the node, moves to state 5 once min was stable long enough
+static void endRound(le_state_t *le) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    uint32_t oldMin = le->min;
+    ipv6_addr_t oldLeader = le->leader;
+    uint8_t oldHops = le->hops, oldSpan = le->span;
+    bool learned = le->config->termination == LE_TERMINATION_DIAMETER && le->diameter == 0;
+    bool last = lastRound(le);
+
+    le->impliedAsked = false;
+    if (DEBUG == 1) {
+        printf("LE: case 3, tempMin=%"PRIu32", min=%"PRIu32", heard from %d neighbors\n", le->tempMin, le->min, le->countedMs);
+    }
+    if (le->term > 0 && le->countedMs == 0) {
+        // the failure may have taken every neighbor with it, silence is no news
+        le->tempMin = le->min;
+        le->tempLeader = le->leader;
+        le->tempHops = le->hops;
+    }
+    ipv6_addr_to_str(ipv6, &le->tempLeader, IPV6_ADDRESS_LEN);
+
+    if (le->tempMin < le->min) {
+        printf("LE: case <, tempMin=%"PRIu32" < min=%"PRIu32", stable rounds reset\n", le->tempMin, le->min);
+        le->min = le->tempMin;
+        le->leader = le->tempLeader;
+        le->hops = le->tempHops + 1;
+        le->stable = 0;
+    } else if (le->tempMin == le->min && le->stable + 1 < le->target) {
+        le->stable = le->stable + 1;
+        printf("LE: case ==, tempMin=%"PRIu32" == min=%"PRIu32", stable for %d of %d rounds\n", le->tempMin, le->min, le->stable, le->target);
+        int tie = minIPv6(&le->leader, &le->tempLeader);
+        if (tie == 1) {
+            // new leader wins tie
+            printf("LE: tempLeader (%s) wins tie over (%s)\n", ipv6, le->leaderStr);
+            le->leader = le->tempLeader;
+            le->hops = le->tempHops + 1;
+        } else {
+            // else the old leader won the tie, so no change
+            printf("LE: existing leader (%s) wins tie\n", le->leaderStr);
+            if (tie == 0 && le->tempHops + 1 < le->hops) {
+                le->hops = le->tempHops + 1; // a shorter path to the same leader
             }
         }
-        xtimer_usleep(50000); // wait 0.05 seconds
+    } else if (last) {
+        printf("LE case finish, stable for %d rounds so quit\n", le->target);
+        setState(le, 5);
     }
+    ipv6_addr_to_str(le->leaderStr, &le->leader, IPV6_ADDRESS_LEN);
 
-    // thread startup complete
-    printf("Topology assignment complete, %d neighbors:\n",numNeighbors);
-    c = 1;
-    for (i = 0; i < numNeighbors; i++) {
-        if (strcmp(neighbors[i],"") == 0) {
-            continue;
+    // a longer leader distance may mean a larger network than assumed
+    if (le->hops > le->span) {
+        le->span = le->hops;
+    }
+    if (learned && le->span > le->roundSpan && le->stable > 0) {
+        printf("LE: a leader %u hops away was heard of, stable rounds reset\n", le->span);
+        le->stable = 0;
+    }
+    le->roundSpan = le->span;
+    if (le->stateLE == 3 && stableTarget(le) > le->target) {
+        le->target = stableTarget(le);
+        printf("LE: leader is %u hops away, now terminating after %d stable rounds\n", le->span, le->target);
+    }
+
+    if (le->dropStale + le->dropDup > 0) {
+        printf("LE: round %u dropped %d stale and %d duplicate acks\n", le->round, le->dropStale, le->dropDup);
+    }
+    le->dropStaleTotal += le->dropStale;
+    le->dropDupTotal += le->dropDup;
+    le->dropStale = 0;
+    le->dropDup = 0;
+
+    // anything our ack carries changed, the neighbors need to hear it
+    bool changed = le->min != oldMin || !ipv6_addr_equal(&le->leader, &oldLeader) ||
+                   le->hops != oldHops || le->span != oldSpan;
+
+    if (le->stateLE == 3) {
+        // line 6 of pseudocode
+        le->round++;
+        le->countedMs = le_nbr_reset_round(le->neighbors, le->round, &le->impliedMs);
+        if (le->impliedMs > 0 && lastRound(le)) {
+            impliedEnd(le); // only a round every neighbor reported in may end the election
+        }
+        le->tempMin = bestReported(le);
+        if (changed) {
+            le->ackReset = true;
+        }
+        if (skipAck(le)) {
+            le->ackSkipped++;
+        } else {
+            sendAck(le);
+        }
+        if (le->impliedAsked) {
+            sendQuery(le); // a neighbor that is not behind answers right away
+        }
+        le->askedAt = xtimer_now_usec();
+        impliedStart(le);
+
+        // go back to line 5 of pseudocode, sleep out the rest of T1
+        setState(le, 2);
+        uint32_t elapsed = xtimer_now_usec() - le->lastT1;
+        le->deadline = setDeadline(le, (elapsed < le->t1) ? (le->t1 - elapsed) : 0);
+
+        // a round the neighbors already reported for, ahead of us or by
+        // staying quiet, only waits for their usual response time
+        if (le->countedMs + le->impliedMs >= le->neighbors->numIn) {
+            le->deadline = setDeadline(le, le->impliedDue);
         }
-        printf("%2d: %s\n", c, neighbors[i]);
-        c += 1;
     }
-    quit = false;
+}
 
-    // main thread execution loop
-    while (1) {
-        if (quit) break;
-        // receive messages
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        res = msg_try_receive(&msg_p_in);
+// Purpose: one event of the election, an IPC message from the UDP thread
+// or the expiry of a T1/T2 deadline, then advance the state machine
+//
+// le le_state_t*, the node
+// msg msg_t*, the message
+// event ipc_event_t*, its event block, NULL for untyped messages
+static void handleElection(le_state_t *le, msg_t *msg, ipc_event_t *event) {
+    int numNeighbors = le->neighbors->numIn; // a round waits for the links we hear
+    bool expired = false;   // the armed deadline fired on this event
+
+    // processing
+    if (msg->type == LE_TIMER_MSG_TYPE) {
+        if (msg->content.value != le->deadline) {
+            return; // a deadline that was replaced before it fired
+        }
+        le->deadline = 0;
+        expired = true;
 
-        if (res == 1) {
-            // processing
-            if (msg_p_in.type > 2 && msg_p_in.type < MAX_IPC_MESSAGE_SIZE) { // process string message of size msg_p_in.type
+    } else if (msg->type == IPC_LEADER_QUERY) {
 
-                //printf("LE: in type>2 block, type=%u\n", (uint16_t)msg_p_in.type);
-                strncpy(msg_content, (char*)msg_p_in.content.ptr, (uint16_t)msg_p_in.type+1);
-                if (DEBUG == 1) {
-                    printf("LE: Protocol thread received IPC message: %s from PID=%" PRIkernel_pid " with type=%d\n", msg_content, msg_p_in.sender_pid, msg_p_in.type);
-                }
+        replyLeader(le, msg);
 
-            } else {
+    } else if (msg->type == IPC_RX_ACK) {
 
-                (void) puts("LE: Protocol thread received an illegal or too large IPC message");
-                continue;
+        handleAck(le, &event->ack);
 
-            }
+    } else if (msg->type == IPC_RX_QUERY) {
 
-            // react
+        // someone wants my m
+        if (event->query.epoch == le->epoch) {
+            sendAck(le);
+        }
+
+    } else if (msg->type == IPC_RX_DONE) {
+
+        // a neighbor finished, stop now unless we already know a better leader
+        char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+        le_wire_done_t *done = &event->done;
+        if (done->epoch != le->epoch || done->term != le->term) {
+            le->dropStale++;
+        } else if (done->m < le->min || (done->m == le->min && minIPv6(&le->leader, &done->leader) >= 0)) {
+            le->min = done->m;
+            le->leader = done->leader;
+            ipv6_addr_to_str(le->leaderStr, &le->leader, IPV6_ADDRESS_LEN);
+            printf("LE: le_done from %s, finishing with leader %s\n",
+                   ipv6_addr_to_str(ipv6, &event->src, IPV6_ADDRESS_LEN), le->leaderStr);
+            setState(le, 5);
+        } else {
+            printf("LE: ignoring le_done for m=%d, ours is %"PRIu32"\n", done->m, le->min);
+        }
+
+    } else if (msg->type == LE_HB_MSG_TYPE) {
+
+        // heartbeats only matter once a leader is elected
+
+    } else if (!IPC_OWNS_EVENT(msg->type)) {
+
+        printf("LE: Protocol thread received an illegal IPC message, type=0x%04x\n", msg->type);
+
+    }
+
+    // perform leader election, states fall through when no wait is needed
+    if (le->stateLE == 1) { // case 1: line 4 of psuedocode
+        if (le->countedMs == numNeighbors || expired) {
             if (DEBUG == 1) {
-                printf("LE: message received: %s\n", msg_content);
-            }
-            if (strncmp(msg_content, "le_ack:", 7) == 0) {
-                // a neighbor has responded
-                // le_ack:mmm:ipv6_owner;ipv6_sender
-                substr(msg_content, 7, 3, neighborM); // obtain m value
-                //printf("LE: extracted m=%s\n", neighborM);
-                int j = indexOfSemi(msg_content);
-                substr(msg_content, 11, j-11-1, ipv6); // obtain ID
-                substr(msg_content, j+1, IPV6_ADDRESS_LEN, ipv6_2); // obtain neighbor ID
-                i = getNeighborIndex(neighbors, ipv6_2);
-
-                if (atoi(neighborM) <= 0) continue;
-
-                printf("LE: m value %d received from %s, owner %s\n", atoi(neighborM), ipv6_2, ipv6);
-                if (neighborsVal[i] == 0) countedMs++;
-                neighborsVal[i] = (uint32_t)atoi(neighborM);
-                if (neighborsVal[i] < tempMin) {
-                    strcpy(tempLeader, ipv6);
-                    tempMin = neighborsVal[i];
-                    printf("LE: new tempMin=%"PRIu32", tempLeader=%s\n", tempMin, tempLeader);
-                } 
-            } else if (strncmp(msg_content, "le_m?:", 6) == 0) {
-                // someone wants my m              
-                //char *msg = (char*)calloc(MAX_IPC_MESSAGE_SIZE, sizeof(char));
-                //strcpy(msg, "le_ack:");                
-                char msg[MAX_IPC_MESSAGE_SIZE] = "le_ack:";                 
-                if(min < 10) {
-                    sprintf(neighborM, "00%"PRIu32"",min);
-                } else if (min < 100) {
-                    sprintf(neighborM, "0%"PRIu32"",min);
-                } else {
-                    sprintf(neighborM, "%"PRIu32"",min);
-                }
-                strcat(msg,neighborM);
-                strcat(msg,":");
-                strcat(msg,leader);
-                strcat(msg,";");
-                strcat(msg,myIPv6);
-                ipc_msg_send(msg, udpServerPID, false);
-                //free(msg);
+                printf("LE: case 1, tempMin=%"PRIu32", min=%"PRIu32", heard from %d neighbors\n", le->tempMin, le->min, le->countedMs);
             }
+            // the answers to our query are the values of round 0
+            setState(le, 2);
+            expired = false;
         }
+    }
 
-        // leader election
-        if (!runningLE && !hasElectedLeader) {
-            // check if it's time to run, then initialize
-            if (numNeighbors > 0 && !hasElectedLeader && allowLE) {
-                (void) puts("LE: Starting leader election...");
-                runningLE = true;
-                allowLE = false;
-                startTimeLE = xtimer_now_usec();
-                counter = K;
-                stateLE = 0;
-            }
-        } else if (runningLE) {
-            // perform leader election
-            if (stateLE == 0) { // case 0: send out multicast ping
-                    if (DEBUG == 1) {
-                        printf("LE: case 0, leader=%s, min=%"PRIu32"\n", leader, min);
-                    }
-                    ipc_msg_send(initLE, udpServerPID, false);
-                    stateLE = 1;
-                    countedMs = 0;
-                    lastT2 = xtimer_now_usec();
-            } else if (stateLE == 1) { // case 1: line 4 of psuedocode
-                    if (countedMs == numNeighbors || lastT2 < xtimer_now_usec() - t2) {
-                        if (DEBUG == 1) {
-                            printf("LE: case 1, tempMin=%"PRIu32", min=%"PRIu32", heard from %d neighbors\n", tempMin, min, countedMs);
-                        }
-                        stateLE = 2;
-                        lastT2 = xtimer_now_usec();
-                        tempMin = 257;
-                        countedMs = 0;
-                        for (i = 0; i < numNeighbors; i++) {
-                            neighborsVal[i] = 0;
-                        }
-                    }
-            } else if (stateLE == 2) { // case 2: line 5 of pseudocode
-                    if (lastT1 < xtimer_now_usec() - t1) {
-                        if (DEBUG == 1) {
-                            printf("LE: case 2, tempMin=%"PRIu32", min=%"PRIu32", counter==%d\n", tempMin, min, counter);
-                        }
-                        stateLE = 3;
-                        lastT2 = xtimer_now_usec();
-                        lastT1 = xtimer_now_usec();
-                    }
-            } else if (stateLE == 3) { // case 3: lines 5a-f of pseudocode, some contained in response above
-                    //countedMs == numNeighbors || 
-                    if (lastT2 < xtimer_now_usec() - t2) {
-                        //char *msg;
-
-                        if (DEBUG == 1) {
-                            printf("LE: case 3, tempMin=%"PRIu32", min=%"PRIu32", heard from %d neighbors\n", tempMin, min, countedMs);
-                        }
-                        
-                        if (tempMin < min) {
-                            printf("LE: case <, tempMin=%"PRIu32" < min=%"PRIu32", counter reset to %d\n", tempMin, min, K);
-                            min = tempMin;
-                            strcpy(leader, tempLeader);
-                            counter = K;
-                        } else if (tempMin == min && counter > 0) {
-                            printf("LE: case ==, tempMin=%"PRIu32" == min=%"PRIu32", counter reduced to %d\n", tempMin, min, counter-1);
-                            counter = counter - 1;
-                            int tie = minIPv6(leader, tempLeader);
-                            if (tie == 1) {
-                                // new leader wins tie
-                                printf("LE: tempLeader (%s) wins tie over (%s)\n", tempLeader, leader);
-                                strcpy(leader, tempLeader);
-                            } else {
-                                // else the old leader won the tie, so no change
-                                printf("LE: existing leader (%s) wins tie\n", leader);
-                            }
-                        } else if (counter == 0) {
-                            printf("LE case finish, counter == 0 so quit\n");
-                            stateLE = 5;
-                        }
-
-                        if (stateLE == 3) {
-                            tempMin = 257;
-                            countedMs = 0;
-                            for (i = 0; i < numNeighbors; i++) {
-                                neighborsVal[i] = 0;
-                            }
-
-                            // line 6 of pseudocode        
-                            //msg = (char*)calloc(MAX_IPC_MESSAGE_SIZE, sizeof(char));
-                            //strcpy(msg, "le_ack:");  
-                            char msg[MAX_IPC_MESSAGE_SIZE] = "le_ack:";         
-                            if(min < 10) {
-                                sprintf(neighborM, "00%"PRIu32"",min);
-                            } else if (min < 100) {
-                                sprintf(neighborM, "0%"PRIu32"",min);
-                            } else {
-                                sprintf(neighborM, "%"PRIu32"",min);
-                            }
-                            strcat(msg,neighborM);
-                            strcat(msg,":");
-                            strcat(msg,leader);
-                            strcat(msg,";");
-                            strcat(msg,myIPv6);
-                            ipc_msg_send(msg, udpServerPID, false);
-                            stateLE = 2;
-                            //free(msg);
-                            }
-                    }
-
-                    // go back to line 5 of pseudocode
-                    //if (lastT1 < xtimer_now_usec() - t1) {
-                    //    stateLE = 2;
-                    //}
-            } else if (stateLE == 5) {
-                    printf("LE: %s elected as the leader, via m=%"PRIu32"!\n", leader, min);
-                    if (strcmp(leader, myIPv6) == 0) {
-                        printf("LE: Hey, that's me! I'm the leader!\n");
-                    }
-                    //char* msg = (char*)calloc(MAX_IPC_MESSAGE_SIZE,sizeof(char));
-                    //strcpy(msg, "le_done:");
-                    //char msg[MAX_IPC_MESSAGE_SIZE] = "le_done:";                     
-                    //ipc_msg_send(msg, udpServerPID, false);
-                    //free(msg);
-                    endTimeLE = xtimer_now_usec();
-                    convergenceTimeLE = (endTimeLE - startTimeLE);
-                    printf("LE:    start=%"PRIu32"\n", startTimeLE);
-                    printf("LE:      end=%"PRIu32"\n", endTimeLE);
-                    printf("LE: converge=%"PRIu32"\n", convergenceTimeLE);
-                    //printf("LE: leader election took %.3f seconds to converge\n", convergenceTimeLE);
-                    runningLE = false;
-                    hasElectedLeader = true;
-                    countedMs = 0;
-                    stateLE = 0;
-                    quit = true;
-            } else {
-                    printf("LE: leader election in invalid state %d\n", stateLE);
-                    break;
+    if (le->stateLE == 2) { // case 2: line 5 of pseudocode
+        if (le->lastT1 == 0 || expired || roundComplete(le, numNeighbors)) {
+            // T2 covers the slowest neighbor's response time, T1 keeps the original 3:2 ratio
+            le->t2 = le_nbr_rto(le->neighbors, le->config->rtoMin, le->config->rtoMax, le->config->t2);
+            le->t1 = le->t2 + le->t2 / 2;
+            if (DEBUG == 1) {
+                printf("LE: case 2, tempMin=%"PRIu32", min=%"PRIu32", stable=%d/%d, t2=%"PRIu32"\n", le->tempMin, le->min, le->stable, le->target, le->t2);
             }
+            setState(le, 3);
+            expired = false;
+            le->lastT1 = xtimer_now_usec();
+            le->deadline = setDeadline(le, le->t2);
+        } else if (le->deadline == 0) {
+            // wait out the rest of T1, measured from the start of the round
+            uint32_t elapsed = xtimer_now_usec() - le->lastT1;
+            le->deadline = setDeadline(le, (elapsed < le->t1) ? (le->t1 - elapsed) : 0);
         }
-        
-        xtimer_usleep(50000); // wait 0.05 seconds
-        //printf("LE: bottom\n");
     }
-    if (DEBUG == 1) {
-        printf("LE: quit main loop\n");
+
+    if (le->stateLE == 3) { // case 3: lines 5a-f of pseudocode, some contained in response above
+        // the round ends as soon as every neighbor reported, or at the timeout
+        if (expired || roundComplete(le, numNeighbors)) {
+            endRound(le);
+        }
     }
-    // if the master node needs information from this protocol thread
-    // send IPC messages to the UDP thread to forward to the master node
 
-    char msg[MAX_IPC_MESSAGE_SIZE] = "results;";
-	char tempTime[10];
-	strcat(msg, leader);
-    strcat(msg, ";");
-	sprintf(tempTime , "%"PRIu32 , convergenceTimeLE);
-    strcat(msg, tempTime);
-    strcat(msg, ";");
-    if (DEBUG == 1) {
-        printf("LE: sending results: %s\n", msg);
+    if (le->stateLE == 5) {
+        printf("LE: %s elected as the leader, via m=%"PRIu32"!\n", le->leaderStr, le->min);
+        if (ipv6_addr_equal(&le->leader, &le->myIPv6)) {
+            printf("LE: Hey, that's me! I'm the leader!\n");
+        }
+        uint32_t endTimeLE = xtimer_now_usec();
+        le->convergenceTimeLE = (endTimeLE - le->startTimeLE);
+        printf("LE:    start=%"PRIu32"\n", le->startTimeLE);
+        printf("LE:      end=%"PRIu32"\n", endTimeLE);
+        printf("LE: converge=%"PRIu32"\n", le->convergenceTimeLE);
+        printf("LE:   rounds=%u, stable=%d, hops=%u, last t2=%"PRIu32"\n", le->round, le->target, le->hops, le->t2);
+        printf("LE:  dropped %d stale and %d duplicate acks, skipped %d\n", le->dropStaleTotal + le->dropStale,
+               le->dropDupTotal + le->dropDup, le->ackSkipped);
+        if (le->term > 0) {
+            le->failoverTime = endTimeLE - le->failoverStart;
+            printf("LE: failover=%"PRIu32", term %u\n", le->failoverTime, le->term);
+        }
+        sendDone(le);
+        le->hasElectedLeader = true;
+        le->countedMs = 0;
+        setState(le, 0);
+        finishElection(le);
+    } else if (le->stateLE < 1 || le->stateLE > 3) {
+        printf("LE: leader election in invalid state %d\n", le->stateLE);
+        finishElection(le);
+    }
+}
+
+// Purpose: after the election, stay up to report the leader
+//
+// le le_state_t*, the node
+// msg msg_t*, the message
+// event ipc_event_t*, its event block, NULL for untyped messages
+static void handleFinished(le_state_t *le, msg_t *msg, ipc_event_t *event) {
+    if (msg->type == IPC_LEADER_QUERY) { // report about the leader
+        if (DEBUG == 1) {
+            printf("LE: reporting that the leader is %s\n", le->leaderStr);
+        }
+        replyLeader(le, msg);
+
+    // other nodes might be one K value behind and still need confirmation
+    } else if (msg->type == IPC_RX_QUERY && event->query.epoch == le->epoch) {
+        // someone wants my m; an ack would carry our last round, which a node
+        // that ran ahead drops, the elected leader lets it finish right away
+        if (le->hasElectedLeader) {
+            sendDone(le);
+        } else {
+            sendAck(le);
+        }
+
+    } else if (msg->type == IPC_RX_HB) {
+
+        handleHeartbeat(le, &event->hb);
+
+    } else if (msg->type == LE_HB_MSG_TYPE) {
+
+        // the listening time of a heartbeat is over
+        uint8_t redundancy = le->config->hbRedundancy;
+        if (msg->content.value == le->hbSeq && (redundancy == 0 || le->hbHeard < redundancy)) {
+            sendHeartbeat(le);
+        }
+
+    } else if (msg->type == LE_TIMER_MSG_TYPE) {
+
+        if (msg->content.value != le->deadline) {
+            return; // a deadline that was replaced before it fired
+        }
+        le->deadline = 0;
+        if (ipv6_addr_equal(&le->leader, &le->myIPv6)) {
+            le->hbSeq++;
+            sendHeartbeat(le);
+            le->deadline = setDeadline(le, le->config->hbPeriod);
+        } else if (le->term < UINT8_MAX) {
+            printf("LE: no heartbeat from %s for %"PRIu32" usec, presumed dead\n", le->leaderStr,
+                   xtimer_now_usec() - le->hbLast);
+            reelect(le, le->term + 1, 0);
+        }
+    }
+}
+
+// Purpose: the term of an le_ack or le_done of this run that is newer than
+// ours, its sender lost the leader and already re-elects
+//
+// le le_state_t*, the node
+// msg msg_t*, the message
+// event ipc_event_t*, its event block, NULL for untyped messages
+// return the newer term, 0 if the message has none
+static uint8_t newerTerm(const le_state_t *le, const msg_t *msg, const ipc_event_t *event) {
+    if (le->phase == LE_PHASE_SETUP) {
+        return 0;
+    }
+    if (msg->type == IPC_RX_ACK && event->ack.epoch == le->epoch && event->ack.term > le->term) {
+        return event->ack.term;
+    }
+    if (msg->type == IPC_RX_DONE && event->done.epoch == le->epoch && event->done.term > le->term) {
+        return event->done.term;
+    }
+    return 0;
+}
+
+// Purpose: process one message for a node
+//
+// le le_state_t*, the node
+// msg msg_t*, the message, typed events hand us their block which is freed here
+void le_handle(le_state_t *le, msg_t *msg) {
+    ipc_event_t *event = IPC_OWNS_EVENT(msg->type) ? (ipc_event_t *)msg->content.ptr : NULL;
+
+    if (msg->type == LE_TIMER_MSG_TYPE && msg->content.value == le->deadline) {
+        TRACE(TRACE_TIMER, TRACE_TIMER_DEADLINE, le->round);
+    } else if (msg->type == LE_HB_MSG_TYPE) {
+        TRACE(TRACE_TIMER, TRACE_TIMER_HB, le->round);
+    }
+
+    // the master can prepare another run in any phase
+    if (msg->type == IPC_RX_RESET) {
+        le_reset(le, event->reset.m);
+        ipc_free(event);
+        return;
+    }
+
+    // join a re-election we have not noticed the need for yet, then handle
+    // the message as part of it
+    uint8_t term = newerTerm(le, msg, event);
+    if (term > 0) {
+        reelect(le, term, (msg->type == IPC_RX_ACK) ? event->ack.round : 0);
+    }
+
+    switch (le->phase) {
+        case LE_PHASE_SETUP:
+            handleSetup(le, msg, event);
+            break;
+        case LE_PHASE_ELECTION:
+            handleElection(le, msg, event);
+            break;
+        case LE_PHASE_FINISHED:
+            handleFinished(le, msg, event);
+            break;
+    }
+    ipc_free(event);
+}
+
+// ************************************
+// START MY CUSTOM THREAD DEFS
+
+// Purpose: launch the procotol thread
+//
+// argc int, argument count (should be 2)
+// argv char**, list of arguments ("leader_election",<port>)
+kernel_pid_t leader_election(int argc, char **argv) {
+    if (argc != 2) {
+        puts("Usage: leader_election <port>");
+        return 0;
     }
-    ipc_msg_send(msg, udpServerPID, false);
 
-    for(int i = 0; i < MAX_NEIGHBORS; i++) {
-        free(neighbors[i]);
+    kernel_pid_t protocolPID = thread_create(protocol_stack, sizeof(protocol_stack), THREAD_PRIORITY_MAIN - 1, THREAD_CREATE_STACKTEST, _leader_election, argv[1], "Protocol_Thread");
+
+    printf("MAIN: thread_create(..., protocol_thread) returned: %" PRIkernel_pid "\n", protocolPID);
+    if (protocolPID <= KERNEL_PID_UNDEF) {
+        (void) puts("MAIN: Error - failed to start leader election thread");
+        return 0;
     }
-    free(neighbors);
 
-    // mini loop that just stays up to report the leader
+    return protocolPID;
+}
+
+// Purpose: the actual protocol thread code
+// Currently implements neighbor discovery and leader election
+//
+// argv void*, exists for RIOT semantics purposes (unused)
+void *_leader_election(void *argv) {
+    (void)argv;
+    msg_init_queue(_protocol_msg_queue, MAIN_QUEUE_SIZE);
+
+    le_config_default(&le_config);
+    le_init(&le_state, &le_config, &neighbors);
+
+    printf("LE: Success - started protocol thread with m=%"PRIu32"\n", le_state.m);
+
+    // main thread loop, sleeps until a message arrives, each one is one event
     while (1) {
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        res = msg_try_receive(&msg_p_in);
-        if (res == 1) {
-            if (msg_p_in.type > 2 && msg_p_in.type < MAX_IPC_MESSAGE_SIZE) { 
-                // process string message of size msg_p_in.type
-                //printf("LE: in type>2 block, type=%u\n", (uint16_t)msg_p_in.type);
-                strncpy(msg_content, (char*)msg_p_in.content.ptr, (uint16_t)msg_p_in.type+1);
-                if (DEBUG == 1) {
-                    printf("LE: Protocol thread received IPC message: %s from PID=%" PRIkernel_pid " with type=%d\n", msg_content, msg_p_in.sender_pid, msg_p_in.type);
-                }
-
-            } 
-
-            if (msg_p_in.type == 2) { // report about the leader
-                if (DEBUG == 1) {
-                    printf("LE: reporting that the leader is %s\n", leader);
-                }
-                ipc_msg_reply(leader, msg_p_in);
-                continue;
-
-            // other nodes might be one K value behind and still need confirmation
-            } else if (strncmp(msg_content, "le_m?:", 6) == 0) {
-                // someone wants my m              
-                char msg[MAX_IPC_MESSAGE_SIZE] = "le_ack:";               
-                if(min < 10) {
-                    sprintf(neighborM, "00%"PRIu32"",min);
-                } else if (min < 100) {
-                    sprintf(neighborM, "0%"PRIu32"",min);
-                } else {
-                    sprintf(neighborM, "%"PRIu32"",min);
-                }
-                strcat(msg,neighborM);
-                strcat(msg,":");
-                strcat(msg,leader);
-                strcat(msg,";");
-                strcat(msg,myIPv6);
-                ipc_msg_send(msg, udpServerPID, false);
-            }
-        }
-        xtimer_usleep(50000); // wait 0.05 seconds
+        msg_receive(&msg_p_in);
+        le_handle(&le_state, &msg_p_in);
     }
 
     return 0;
@@ -0,0 +1,140 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Leader election state machine of a worker node.
+ *
+ * All state of one node lives in an le_state_t and le_handle() processes one
+ * message at a time, so the same code runs in the RIOT protocol thread and,
+ * many nodes at once, in the host simulator (cpsiot_sim).
+ *
+ * After the election the leader floods a heartbeat every hbPeriod. Nodes
+ * pass each one on after a random delay unless they already heard it
+ * hbRedundancy times, Trickle style. A node that hears none for hbTimeout
+ * declares the leader dead and starts a re-election in the next term; its
+ * acks pull the other nodes into that term. A re-election keeps the
+ * neighbors' response times and the learned diameter, so it starts on the
+ * adaptive timeout instead of T1/T2.
+ *
+ * Round acks are suppressed Trickle style while the election is stable. A
+ * node that heard ackRedundancy consistent reports (same min and leader as
+ * its own) in a round announces in its next ack that it will skip the
+ * following rounds, twice as many each time up to ackQuietMax. Its
+ * neighbors let that ack stand in for the skipped ones once its usual
+ * response time has passed, so rounds keep their pace. Any change to what
+ * it would send, or an inconsistent ack heard, makes it send again at once.
+ */
+
+#ifndef PROTOCOLS_H
+#define PROTOCOLS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "msg.h"
+#include "xtimer.h"
+#include "net/ipv6/addr.h"
+
+#include "le_nbr.h"
+
+// termination rule: the fixed K countdown, or diameter + epsilon stable
+// rounds with the diameter from the master or learned from the acks
+#define LE_TERMINATION_K        (0)
+#define LE_TERMINATION_DIAMETER (1)
+
+// tunables, defaults come from the Makefile
+typedef struct {
+    uint32_t k;             // stable rounds of the K rule, minus one
+    uint32_t t1;            // round period until response times are known, usec
+    uint32_t t2;            // collection window until response times are known, usec
+    uint32_t rtoMin;        // floor of the adaptive round timeout, usec
+    uint32_t rtoMax;        // ceiling of the adaptive round timeout, usec
+    uint8_t termination;    // LE_TERMINATION_K or LE_TERMINATION_DIAMETER
+    uint8_t epsilon;        // extra stable rounds on top of the diameter
+    uint32_t hbPeriod;      // leader heartbeat period after the election, usec, 0 disables
+    uint32_t hbTimeout;     // silence after which the leader is declared dead, usec
+    uint8_t hbRedundancy;   // copies of a heartbeat that suppress passing it on, 0 never suppresses
+    uint8_t ackRedundancy;  // consistent reports in a round that let a node go quiet, 0 never suppresses
+    uint8_t ackQuietMax;    // most rounds skipped after one ack
+} le_config_t;
+
+typedef enum {
+    LE_PHASE_SETUP,         // waiting for the topology and the start message
+    LE_PHASE_ELECTION,      // running the rounds
+    LE_PHASE_FINISHED,      // reporting the leader, answering late queries, watching its heartbeats
+} le_phase_t;
+
+typedef struct {
+    const le_config_t *config;
+    le_nbr_table_t *neighbors;      // filled by the UDP thread
+    kernel_pid_t udpServerPID;
+    uint16_t epoch;                 // election run from the master's start
+    uint8_t term;                   // re-elections within the run
+    le_phase_t phase;
+
+    // deadline timer, one at a time, replaced timers are recognized by generation
+    xtimer_t timer;
+    msg_t timerMsg;
+    uint32_t deadline;              // generation of the armed timer, 0 if none
+
+    ipv6_addr_t myIPv6;
+    uint32_t startTimeLE;
+    uint32_t convergenceTimeLE;
+    bool hasElectedLeader;
+    bool allowLE;
+    bool topoComplete;
+    int stateLE;
+    int countedMs;
+
+    // Ali's LE variables
+    uint32_t m;                     // my leader election value, range 1 to 255
+    uint32_t min;                   // the min of my neighborhood
+    uint32_t tempMin;
+    ipv6_addr_t leader;             // the "leader so far"
+    ipv6_addr_t tempLeader;         // temp leader for a round of communication
+    char leaderStr[IPV6_ADDR_MAX_STR_LEN]; // printable leader
+    uint16_t round;
+    int stable;                     // rounds in a row without a change to min
+    int target;                     // stable rounds needed to finish
+    uint8_t diameter;               // from the master, 0 if unknown
+    uint8_t hops;                   // my distance to leader
+    uint8_t span;                   // largest distance to the leader heard of
+    uint8_t roundSpan;              // span when the last round ended
+    uint8_t tempHops;               // distance of tempLeader from the neighbor that reported it
+
+    uint32_t t1;
+    uint32_t t2;
+    uint32_t lastT1;
+    uint32_t askedAt;               // when our query or current round's ack went out
+
+    // acks thrown away in the current round and over the whole run
+    int dropStale;                  // from an older round or run
+    int dropDup;                    // neighbor already reported for this round
+    int dropStaleTotal;
+    int dropDupTotal;
+
+    // round ack suppression
+    uint8_t ackQuiet;               // rounds skipped after each ack, doubles while consistent
+    uint16_t ackNext;               // next round whose ack goes out
+    uint8_t ackHeard;               // consistent reports heard in the current round
+    bool ackReset;                  // an inconsistency was seen, the next ack goes out
+    int impliedMs;                  // reports of quiet neighbors standing in this round
+    uint32_t impliedDue;            // usec after askedAt when they count
+    bool impliedAsked;              // neighbors were queried, acks count from one round back only
+    int ackSkipped;                 // acks suppressed over the run
+
+    // leader liveness after the election
+    xtimer_t hbTimer;               // delay before passing a heartbeat on
+    msg_t hbMsg;
+    uint16_t hbSeq;                 // newest heartbeat sent or heard in this term
+    uint8_t hbHeard;                // copies of it heard
+    uint32_t hbLast;                // when it arrived
+    uint32_t failoverStart;         // last sign of life of the leader that was lost
+    uint32_t failoverTime;          // from failoverStart until the new leader was elected
+} le_state_t;
+
+void le_config_default(le_config_t *config);
+void le_init(le_state_t *le, const le_config_t *config, le_nbr_table_t *neighbors);
+void le_reset(le_state_t *le, uint32_t m);
+void le_handle(le_state_t *le, msg_t *msg);
+
+#endif /* PROTOCOLS_H */
@@ -0,0 +1,110 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Event trace ring and its CSV dump, see trace.h.
+ */
+
+// Standard C includes
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Standard RIOT includes
+#include "irq.h"
+#include "xtimer.h"
+
+#include "le_wire.h"
+#include "trace.h"
+
+#if LE_TRACE
+
+#if (LE_TRACE_SIZE & (LE_TRACE_SIZE - 1)) != 0
+#error "LE_TRACE_SIZE must be a power of two"
+#endif
+#define TRACE_MASK              (LE_TRACE_SIZE - 1)
+
+// Data structures (i.e. stacks, queues, message structs, etc)
+static trace_rec_t ring[LE_TRACE_SIZE];
+
+// State variables
+static uint32_t traceNext = 0;      // records ever written, the ring index is its low bits
+static uint32_t traceMissed = 0;    // records refused while a dump was reading the ring
+static volatile bool tracePaused = false;
+
+static const char *const kindNames[] = { "?", "state", "phase", "rx", "tx", "timer" };
+static const char *const timerNames[] = { "deadline", "hb", "fanout", "pong", "start", "hello" };
+
+// Purpose: append one record, overwriting the oldest once the ring is full
+//
+// kind uint8_t, TRACE_*
+// a uint8_t, first argument, see trace.h
+// b uint16_t, second argument
+void trace_record(uint8_t kind, uint8_t a, uint16_t b) {
+    uint32_t now = xtimer_now_usec();
+    unsigned state = irq_disable();
+
+    if (tracePaused) {
+        traceMissed++;
+    } else {
+        trace_rec_t *rec = &ring[traceNext & TRACE_MASK];
+        rec->time = now;
+        rec->kind = kind;
+        rec->a = a;
+        rec->b = b;
+        traceNext++;
+    }
+    irq_restore(state);
+}
+
+// Purpose: print one record as a CSV row
+static void printRecord(const trace_rec_t *rec) {
+    const char *kind = (rec->kind < sizeof(kindNames) / sizeof(kindNames[0])) ? kindNames[rec->kind] : "?";
+
+    if (rec->kind == TRACE_RX || rec->kind == TRACE_TX) {
+        printf("%"PRIu32",%s,%s,%u\n", rec->time, kind, le_wire_type_name(rec->a), rec->b);
+    } else if (rec->kind == TRACE_TIMER && rec->a < sizeof(timerNames) / sizeof(timerNames[0])) {
+        printf("%"PRIu32",%s,%s,%u\n", rec->time, kind, timerNames[rec->a], rec->b);
+    } else {
+        printf("%"PRIu32",%s,%u,%u\n", rec->time, kind, rec->a, rec->b);
+    }
+}
+
+#endif /* LE_TRACE */
+
+// Purpose: print the trace as CSV, oldest record first, or empty it;
+// recording pauses while the ring is read
+//
+// argc int, number of arguments (1 or 2)
+// argv char**, list of arguments ("letrace", [clear])
+int trace_dump(int argc, char **argv) {
+    bool clear = (argc == 2 && strcmp(argv[1], "clear") == 0);
+
+    if (argc > 2 || (argc == 2 && !clear)) {
+        (void) puts("TRACE: Usage - letrace [clear]");
+        return -1;
+    }
+#if LE_TRACE
+    unsigned state = irq_disable();
+    tracePaused = true;
+    uint32_t next = traceNext;
+    irq_restore(state);
+
+    uint32_t count = (next < LE_TRACE_SIZE) ? next : LE_TRACE_SIZE;
+    if (clear) {
+        printf("TRACE: cleared %"PRIu32" records, %"PRIu32" overwritten and %"PRIu32" missed during dumps\n",
+               count, next - count, traceMissed);
+        traceNext = 0;
+        traceMissed = 0;
+    } else {
+        (void) puts("time_us,event,value,arg");
+        for (uint32_t i = next - count; i != next; i++) {
+            printRecord(&ring[i & TRACE_MASK]);
+        }
+    }
+    tracePaused = false;
+#else
+    (void) puts("TRACE: not built in, rebuild with LE_TRACE=1");
+#endif
+    return 0;
+}
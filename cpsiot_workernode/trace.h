@@ -0,0 +1,64 @@
+/*
+ * @author  Michael Conard <maconard@mtu.edu>
+ *
+ * Purpose: Event trace of the worker, a ring of timestamped binary records.
+ *
+ * Built with LE_TRACE=1, the protocol thread records its state changes and
+ * timer expiries and the UDP thread every frame it receives or sends, with
+ * the message type and the neighbor's index. A record is 8 bytes and costs a
+ * timestamp and a few stores, nothing is printed until the letrace shell
+ * command dumps the ring as CSV, so tracing leaves the timing of a run alone.
+ * Once the ring is full the oldest records are overwritten. With LE_TRACE=0
+ * TRACE() compiles to nothing and its arguments are not evaluated.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#ifndef LE_TRACE
+#define LE_TRACE                (0)
+#endif
+
+// records kept, a power of two
+#ifndef LE_TRACE_SIZE
+#define LE_TRACE_SIZE           (512)
+#endif
+
+// kinds of records and the meaning of their arguments
+#define TRACE_STATE             (1)     // a: new stateLE, b: round
+#define TRACE_PHASE             (2)     // a: new le_phase_t, b: term
+#define TRACE_RX                (3)     // a: le_wire type, b: neighbor index
+#define TRACE_TX                (4)     // a: le_wire type, b: neighbor index
+#define TRACE_TIMER             (5)     // a: TRACE_TIMER_*, b: round or 0
+
+// the timers whose expiry is recorded
+#define TRACE_TIMER_DEADLINE    (0)     // T1/T2, round end, heartbeat timeout
+#define TRACE_TIMER_HB          (1)     // heartbeat pass-on delay
+#define TRACE_TIMER_FANOUT      (2)     // next unicast of a fan-out
+#define TRACE_TIMER_PONG        (3)     // pong backoff
+#define TRACE_TIMER_START       (4)     // scheduled start
+#define TRACE_TIMER_HELLO       (5)     // Trickle interval of the hellos
+
+// neighbor index of the master, a multicast or a node that is not a
+// neighbor, the -1 of le_nbr_find cast to the field
+#define TRACE_PEER_NONE         (0xFFFF)
+
+typedef struct {
+    uint32_t time;      // usec, our own clock
+    uint8_t kind;       // TRACE_*
+    uint8_t a;
+    uint16_t b;
+} trace_rec_t;
+
+#if LE_TRACE
+void trace_record(uint8_t kind, uint8_t a, uint16_t b);
+#define TRACE(kind, a, b)       trace_record((kind), (uint8_t)(a), (uint16_t)(b))
+#else
+#define TRACE(kind, a, b)       ((void)0)
+#endif
+
+int trace_dump(int argc, char **argv);
+
+#endif /* TRACE_H */
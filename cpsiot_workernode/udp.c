@@ -16,50 +16,147 @@
 
 // Standard RIOT includes
 #include "thread.h"
+#include "mutex.h"
 #include "xtimer.h"
+#include "random.h"
 
 // Networking includes
+#include "net/gnrc.h"
+#include "net/gnrc/netreg.h"
 #include "net/sock/udp.h"
 #include "net/ipv6/addr.h"
+#include "net/ipv6/hdr.h"
+
+// Shared includes
+#include "le_wire.h"
+#include "le_nbr.h"
+#include "le_sync.h"
+#include "le_trickle.h"
+#include "ipc.h"
+#include "trace.h"
 
 #define CHANNEL                 11
 
 #define SERVER_MSG_QUEUE_SIZE   (32)
 #define SERVER_BUFFER_SIZE      (128)
 #define IPV6_ADDRESS_LEN        (46)
-#define MAX_IPC_MESSAGE_SIZE    (128)
-#define MAX_NEIGHBORS           (8)
+
+// 1: send le_m? and le_ack as one link-local multicast per round,
+// 0: unicast them to every neighbor, can be changed at runtime with lemode
+#ifndef LE_MULTICAST
+#define LE_MULTICAST            (0)
+#endif
+
+// gap between the unicasts of one fan-out, keeps the small packet buffer from overflowing
+#define FANOUT_GAP_USEC         (10000)
+#define FANOUT_MSG_TYPE         (0x0200)
+
+// a pong waits a random time within this window, so a dense deployment does
+// not answer a discovery ping all at once
+#ifndef LE_PONG_JITTER_USEC
+#define LE_PONG_JITTER_USEC     (500000)
+#endif
+#define PONG_MSG_TYPE           (0x0201)
+
+// the master schedules the start in its own clock, a start further ahead than
+// this is taken for a bad clock offset and run at once
+#ifndef LE_START_MAX_LEAD_USEC
+#define LE_START_MAX_LEAD_USEC  (10000000)
+#endif
+#define START_MSG_TYPE          (0x0202)
+
+// 1: find the neighbors by radio and elect without a master, 0: the master
+// discovers the nodes and assigns m values and neighbors
+#ifndef LE_AUTONOMOUS
+#define LE_AUTONOMOUS           (0)
+#endif
+
+// hellos are paced by a Trickle timer, a neighbor silent for LE_HELLO_AGE_USEC
+// is dropped, and the election starts once the neighborhood held still for
+// LE_AUTO_SETTLE_USEC
+#ifndef LE_HELLO_IMIN_USEC
+#define LE_HELLO_IMIN_USEC      (1000000)
+#endif
+#ifndef LE_HELLO_IMAX_USEC
+#define LE_HELLO_IMAX_USEC      (16000000)
+#endif
+#ifndef LE_HELLO_AGE_USEC
+#define LE_HELLO_AGE_USEC       (3 * LE_HELLO_IMAX_USEC)
+#endif
+#ifndef LE_AUTO_SETTLE_USEC
+#define LE_AUTO_SETTLE_USEC     (8000000)
+#endif
+#define HELLO_MSG_TYPE          (0x0203)
+#define LE_AUTO_EPOCH           (1)     // there is no master to number the runs
+
+// directions of the traffic counters
+#define STATS_RX                (0)
+#define STATS_TX                (1)
 
 #define DEBUG                   0
 
-// External functions defs
-extern int ipc_msg_send(char *message, kernel_pid_t destinationPID, bool blocking);
-extern int ipc_msg_reply(char *message, msg_t incoming);
-extern int ipc_msg_send_receive(char *message, kernel_pid_t destinationPID, msg_t *response, uint16_t type);
-extern void substr(char *s, int a, int b, char *t);
-extern int indexOfSemi(char *ipv6);
-extern void extractIP(char **s, char *t);
+// traffic of one message type since lestats or a reset last cleared it
+typedef struct {
+    uint32_t frames[2];     // STATS_RX, STATS_TX
+    uint32_t bytes[2];
+    uint32_t sendFail;      // sock_udp_send refused the frame
+    uint32_t parseErr;      // the frame did not decode
+} type_stats_t;
 
 // Forward declarations
 void *_udp_server(void *args);
 int udp_send(int argc, char **argv);
 int udp_send_multi(int argc, char **argv);
+int udp_send_to(const ipv6_addr_t *addr, uint16_t port, const void *data, size_t len);
+int udp_send_ep(const sock_udp_ep_t *remote, const void *data, size_t len);
+int udp_send_multicast(uint16_t port, const void *data, size_t len);
 int udp_server(int argc, char **argv);
+int udp_mode(int argc, char **argv);
+int udp_stats(int argc, char **argv);
 void countMsgOut(void);
 void countMsgIn(void);
 
 // Data structures (i.e. stacks, queues, message structs, etc)
-static char server_buffer[SERVER_BUFFER_SIZE];
+static uint8_t server_buffer[SERVER_BUFFER_SIZE];
 static char server_stack[THREAD_STACKSIZE_DEFAULT];
 static msg_t server_msg_queue[SERVER_MSG_QUEUE_SIZE];
-static sock_udp_t my_sock;
+static gnrc_netreg_entry_t server_reg = GNRC_NETREG_ENTRY_INIT_PID(GNRC_NETREG_DEMUX_CTX_ALL, KERNEL_PID_UNDEF);
 static msg_t msg_u_in, msg_u_out;
+static uint8_t fanout_frame[LE_WIRE_MAX_LEN];
+static xtimer_t fanout_timer;
+static msg_t fanout_msg;
+static xtimer_t pong_timer;
+static msg_t pong_msg;
+static xtimer_t start_timer;
+static msg_t start_msg;
+static xtimer_t hello_timer;
+static msg_t hello_msg;
+static le_trickle_t helloTrickle;
+static type_stats_t typeStats[LE_WIRE_TYPES]; // by message type, [0] frames without a valid header
+static mutex_t statsLock = MUTEX_INIT;         // typeStats, shared with the shell
 int messagesIn = 0;
 int messagesOut = 0;
+int messagesFiltered = 0;
 bool runningLE = false;
+bool useMulticast = LE_MULTICAST;
+le_nbr_table_t neighbors;
 
 // State variables
 static bool server_running = false;
+static size_t fanoutLen = 0;
+static uint16_t fanoutNext = 0;
+static uint32_t fanoutGen = 0;
+static bool pongPending = false;
+static uint32_t pingTx = 0;     // master timestamp of the ping being answered
+static uint32_t pingRx = 0;     // our clock when it arrived
+static le_sync_t masterClock;   // relates our clock to the master's
+static bool beaconed = false;   // beacons replace the discovery estimate
+static uint16_t startEpoch = 0; // last run scheduled, the master repeats its start
+static ipc_event_t *startPending = NULL; // start event waiting for its time
+static uint16_t resetEpoch = 0; // last run a reset prepared us for
+static uint32_t helloGen = 0;   // hello timer armed last, older ones are ignored
+static uint32_t nbrChanged = 0; // our clock when a neighbor last came or went
+static bool autoStarted = false;
 const int SERVER_PORT = 3142;
 
 // Purpose: if LE is running, count the incoming packet
@@ -72,6 +169,272 @@ void countMsgOut(void) {
     if (runningLE) messagesOut += 1;
 }
 
+// Purpose: index of a message type in typeStats
+//
+// type int, the type from le_wire_type, negative for a bad header
+static int statsIndex(int type) {
+    return (type > 0 && type < LE_WIRE_TYPES) ? type : 0;
+}
+
+// Purpose: count a frame received or sent
+//
+// dir int, STATS_RX or STATS_TX
+// type int, its message type, negative for a bad header
+// len size_t, its length in bytes
+static void countFrame(int dir, int type, size_t len) {
+    type_stats_t *stats = &typeStats[statsIndex(type)];
+    mutex_lock(&statsLock);
+    stats->frames[dir]++;
+    stats->bytes[dir] += len;
+    if (type < 0) {
+        stats->parseErr++;
+    }
+    mutex_unlock(&statsLock);
+}
+
+// Purpose: count a frame that sock_udp_send refused
+static void countSendFail(int type) {
+    mutex_lock(&statsLock);
+    typeStats[statsIndex(type)].sendFail++;
+    mutex_unlock(&statsLock);
+}
+
+// Purpose: count a frame that did not decode
+//
+// res int, the result of its le_wire_decode_ function
+// type int, its message type
+// return true if it decoded
+static bool decoded(int res, int type) {
+    if (res != 0) {
+        mutex_lock(&statsLock);
+        typeStats[statsIndex(type)].parseErr++;
+        mutex_unlock(&statsLock);
+    }
+    return res == 0;
+}
+
+// Purpose: fold the counters into the classes of a results report
+//
+// report le_wire_stats_t*, filled in, frame counts saturate
+static void statsReport(le_wire_stats_t *report) {
+    uint32_t rx[LE_WIRE_CLASSES] = { 0 }, tx[LE_WIRE_CLASSES] = { 0 };
+    uint32_t sendFail = 0, parseErr = 0;
+    ipc_stats_t ipc;
+
+    memset(report, 0, sizeof(*report));
+    mutex_lock(&statsLock);
+    for (int i = 0; i < LE_WIRE_TYPES; i++) {
+        int cls = le_wire_class(i);
+        rx[cls] += typeStats[i].frames[STATS_RX];
+        tx[cls] += typeStats[i].frames[STATS_TX];
+        report->rxBytes += typeStats[i].bytes[STATS_RX];
+        report->txBytes += typeStats[i].bytes[STATS_TX];
+        sendFail += typeStats[i].sendFail;
+        parseErr += typeStats[i].parseErr;
+    }
+    mutex_unlock(&statsLock);
+    ipc_stats(&ipc, false);
+
+    for (int i = 0; i < LE_WIRE_CLASSES; i++) {
+        report->rx[i] = (rx[i] > UINT16_MAX) ? UINT16_MAX : rx[i];
+        report->tx[i] = (tx[i] > UINT16_MAX) ? UINT16_MAX : tx[i];
+    }
+    ipc.dropped += ipc.exhausted;
+    report->sendFail = (sendFail > UINT16_MAX) ? UINT16_MAX : sendFail;
+    report->ipcDrop = (ipc.dropped > UINT16_MAX) ? UINT16_MAX : ipc.dropped;
+    report->parseErr = (parseErr > UINT16_MAX) ? UINT16_MAX : parseErr;
+}
+
+// Purpose: start counting from zero, for a new run or after lestats
+static void statsReset(void) {
+    ipc_stats_t ipc;
+    mutex_lock(&statsLock);
+    memset(typeStats, 0, sizeof(typeStats));
+    mutex_unlock(&statsLock);
+    ipc_stats(&ipc, true);
+}
+
+// Purpose: unicast the pending fan-out frame to the next neighbor we have a
+// link to and schedule the one after it, the server keeps receiving in between
+//
+// pid kernel_pid_t, the UDP server thread that receives the pacing timer
+static void fanoutStep(kernel_pid_t pid) {
+    while (fanoutNext < neighbors.count && !(neighbors.entries[fanoutNext].link & LE_NBR_OUT)) {
+        fanoutNext++;
+    }
+    if (fanoutNext >= neighbors.count) {
+        return;
+    }
+    udp_send_ep(&neighbors.entries[fanoutNext].ep, fanout_frame, fanoutLen);
+    fanoutNext++;
+
+    if (fanoutNext < neighbors.count) {
+        fanout_msg.type = FANOUT_MSG_TYPE;
+        fanout_msg.content.value = fanoutGen;
+        xtimer_set_msg(&fanout_timer, FANOUT_GAP_USEC, &fanout_msg, pid);
+    }
+}
+
+// Purpose: send a protocol frame to all neighbors, as one multicast or as
+// paced unicasts, a newer frame replaces one that is still going out
+//
+// frame uint8_t*, the encoded frame
+// len int, its length, nothing is sent if it is not positive
+// pid kernel_pid_t, the UDP server thread
+static void fanout(const uint8_t *frame, int len, kernel_pid_t pid) {
+    if (len <= 0) {
+        return;
+    }
+    if (useMulticast) {
+        udp_send_multicast(SERVER_PORT, frame, len);
+        return;
+    }
+
+    xtimer_remove(&fanout_timer);
+    memcpy(fanout_frame, frame, len);
+    fanoutLen = len;
+    fanoutNext = 0;
+    fanoutGen++;
+    fanoutStep(pid);
+}
+
+// Purpose: arm the hello timer, replacing the one that is armed
+//
+// delay uint32_t, usec until it fires
+// pid kernel_pid_t, the UDP server thread
+static void helloArm(uint32_t delay, kernel_pid_t pid) {
+    helloGen++;
+    hello_msg.type = HELLO_MSG_TYPE;
+    hello_msg.content.value = helloGen;
+    xtimer_set_msg(&hello_timer, delay, &hello_msg, pid);
+}
+
+// Purpose: a neighbor came or went, hello at the shortest interval again
+//
+// pid kernel_pid_t, the UDP server thread
+static void helloChanged(kernel_pid_t pid) {
+    nbrChanged = xtimer_now_usec();
+    uint32_t delay = le_trickle_inconsistent(&helloTrickle, random_uint32());
+    if (delay > 0) {
+        helloArm(delay, pid);
+    }
+}
+
+// Purpose: a hello arrived, add its sender to the neighbors or note that it
+// is still there; the protocol thread has the same priority and never runs
+// while the table changes, and a new sender waits until no election has the
+// table pinned
+//
+// remote ipv6_addr_t*, the sender
+// netif gnrc_netif_t*, the interface it was heard on
+// pid kernel_pid_t, the UDP server thread
+static void helloHeard(const ipv6_addr_t *remote, const gnrc_netif_t *netif, kernel_pid_t pid) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    int nbr = le_nbr_find(&neighbors, remote);
+
+    if (nbr >= 0) {
+        neighbors.entries[nbr].heard = xtimer_now_usec();
+        le_trickle_hear(&helloTrickle);
+        return;
+    }
+    if (neighbors.pinned) {
+        return; // the election's rounds count on the neighbors they started with, its next hello adds it
+    }
+    nbr = le_nbr_add(&neighbors, remote, LE_NBR_BOTH, SERVER_PORT, (netif != NULL) ? (uint16_t)netif->pid : 0);
+    if (nbr < 0) {
+        printf("UDP: Error - neighbor table full (%d), dropped %s\n", LE_MAX_NEIGHBORS,
+               ipv6_addr_to_str(ipv6, remote, IPV6_ADDRESS_LEN));
+        return;
+    }
+    neighbors.entries[nbr].heard = xtimer_now_usec();
+    printf("UDP: found neighbor %s\n", ipv6_addr_to_str(ipv6, remote, IPV6_ADDRESS_LEN));
+    helloChanged(pid);
+}
+
+// Purpose: drop the neighbors that have not been heard for LE_HELLO_AGE_USEC,
+// unless an election is running, its rounds count on the entries they have
+//
+// pid kernel_pid_t, the UDP server thread
+static void helloAge(kernel_pid_t pid) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    uint32_t now = xtimer_now_usec();
+    uint16_t i = 0;
+
+    if (neighbors.pinned) {
+        return; // aged once the election is over
+    }
+
+    while (i < neighbors.count) {
+        le_nbr_t *nbr = &neighbors.entries[i];
+        if (now - nbr->heard <= LE_HELLO_AGE_USEC) {
+            i++;
+            continue;
+        }
+        // the last entry moves into the hole, look at index i again
+        printf("UDP: lost neighbor %s\n", ipv6_addr_to_str(ipv6, &nbr->addr, IPV6_ADDRESS_LEN));
+        le_nbr_remove(&neighbors, &nbr->addr);
+        helloChanged(pid);
+    }
+}
+
+// Purpose: start the election without a master, once per boot and only with
+// a neighbor to elect with
+//
+// leaderPID kernel_pid_t, the protocol thread
+static void autoStart(kernel_pid_t leaderPID) {
+    if (autoStarted || neighbors.count == 0) {
+        return;
+    }
+    ipc_event_t *event = ipc_alloc();
+    if (event == NULL) {
+        return;
+    }
+    autoStarted = true;
+    runningLE = true;
+    event->start.epoch = LE_AUTO_EPOCH;
+    event->start.startAt = 0;
+    printf("UDP: starting the election with %d neighbors\n", neighbors.count);
+    ipc_send(leaderPID, IPC_RX_START, event);
+}
+
+// Purpose: take the place of the master's ips, our own link-local address, a
+// random m and no neighbors yet, then start saying hello
+//
+// netif gnrc_netif_t*, the interface to elect on
+// leaderPID kernel_pid_t, the protocol thread
+// pid kernel_pid_t, the UDP server thread
+// return the m value, 0 if the interface has no link-local address
+static int autoSetup(const gnrc_netif_t *netif, kernel_pid_t leaderPID, kernel_pid_t pid) {
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+    ipv6_addr_t addrs[4]; // link-local, global and a spare, the first suffices
+    int n = (netif != NULL) ? gnrc_netif_ipv6_addrs_get(netif, addrs, sizeof(addrs)) : 0;
+    int i;
+
+    for (i = 0; i < n / (int)sizeof(ipv6_addr_t); i++) {
+        if (ipv6_addr_is_link_local(&addrs[i])) {
+            break;
+        }
+    }
+    ipc_event_t *event = ipc_alloc();
+    if (i >= n / (int)sizeof(ipv6_addr_t) || event == NULL) {
+        ipc_free(event);
+        (void) puts("UDP: Error - no link-local address, cannot elect autonomously");
+        return 0;
+    }
+    memset(&event->ips, 0, sizeof(event->ips));
+    event->ips.m = 1 + random_uint32() % 254;
+    event->ips.self = addrs[i];
+    printf("UDP: autonomous, my IPv6 is: %s, m=%d\n",
+           ipv6_addr_to_str(ipv6, &event->ips.self, IPV6_ADDRESS_LEN), event->ips.m);
+    int m = event->ips.m;
+    ipc_send(leaderPID, IPC_RX_IPS, event);
+
+    le_trickle_init(&helloTrickle, LE_HELLO_IMIN_USEC, LE_HELLO_IMAX_USEC, 0);
+    nbrChanged = xtimer_now_usec();
+    helloArm(le_trickle_start(&helloTrickle, random_uint32()), pid);
+    return m;
+}
+
 // Purpose: main code for the UDP serverS
 void *_udp_server(void *args)
 {
@@ -79,46 +442,43 @@ void *_udp_server(void *args)
 
     // variable declarations
     char ipv6[IPV6_ADDRESS_LEN] = { 0 };
-	char tempipv6[IPV6_ADDRESS_LEN] = { 0 };
-    char masterIP[IPV6_ADDRESS_LEN] = { 0 };
-    char myIPv6[IPV6_ADDRESS_LEN] = { 0 };
-	char convTime[10] = { 0 };
-    char mStr[4] = { 0 };
+    ipv6_addr_t remote = { 0 };
+    ipv6_addr_t masterIP = { 0 };
+    ipv6_addr_t myIPv6 = { 0 };
     int failCount = 0;
     bool discovered = false;
     int i;
     bool topoComplete = false;
+    uint8_t ipsNext = 0; // next ips frame of our assignment
     int m;
     int rconf = 0; // did master confirm results received
+    uint8_t resultsTerm = 0; // term of the results last sent, re-elections are reported again
 
-    char msg_content[MAX_IPC_MESSAGE_SIZE];
-    char portBuf[6];
+    uint8_t frame[LE_WIRE_MAX_LEN];
+    ipc_event_t *event = NULL;
+    size_t bufLen = 0;
+    int bufType = -1;
+    int len;
 
-    int numNeighbors = 0;
-    char **neighbors = (char**)calloc(MAX_NEIGHBORS, sizeof(char*));
+    le_nbr_init(&neighbors);
+    gnrc_netif_t *netif = gnrc_netif_iter(NULL); // first interface, for link-local neighbors
 
-    for(i = 0; i < MAX_NEIGHBORS; i++) {
-        neighbors[i] = (char*)calloc(IPV6_ADDRESS_LEN, sizeof(char));
-    }
-
-    // socket server setup
-    sock_udp_ep_t server = { .port = SERVER_PORT, .family = AF_INET6 };
-    sock_udp_ep_t remote;
+    // server setup, datagrams for our port are delivered to this thread's
+    // message queue next to the IPC requests from the protocol thread
     kernel_pid_t leaderPID = (kernel_pid_t)atoi(args);
+    kernel_pid_t myPid = thread_getpid();
 
-    sprintf(portBuf,"%d",SERVER_PORT);
-
-    // create the socket
-    if(sock_udp_create(&my_sock, &server, NULL, 0) < 0) {
+    server_reg.demux_ctx = (uint32_t)SERVER_PORT;
+    server_reg.target.pid = myPid;
+    if (gnrc_netreg_register(GNRC_NETTYPE_UDP, &server_reg) != 0) {
         return NULL;
     }
 
     server_running = true;
-    printf("UDP: Success - started UDP server on port %u\n", server.port);
+    printf("UDP: Success - started UDP server on port %d\n", SERVER_PORT);
 
-    kernel_pid_t myPid = thread_getpid();
-    msg_u_out.type = 0;
-    msg_u_out.content.ptr = &myPid;
+    msg_u_out.type = IPC_UDP_PID;
+    msg_u_out.content.value = (uint32_t)myPid;
 
     if (DEBUG == 1) {
         printf("UDP: EADDRNOTAVAIL = %d\n", EADDRNOTAVAIL);
@@ -154,265 +514,488 @@ void *_udp_server(void *args)
             break;
         }
 
-        xtimer_sleep(50000); // wait 0.05 seconds
+        xtimer_usleep(50000); // wait 0.05 seconds
+    }
+
+    // without a master we are our own topology
+    if (LE_AUTONOMOUS) {
+        m = autoSetup(netif, leaderPID, myPid);
+        topoComplete = (m != 0);
     }
 
-    // main server loop
+    // main server loop, sleeps until either a datagram or an IPC message arrives
     while (1) {
-        // incoming UDP
-        int res;
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        memset(server_buffer, 0, SERVER_BUFFER_SIZE);
+        int res = 0;
+        msg_receive(&msg_u_in);
 
-        if (server_buffer == NULL || sizeof(server_buffer) - 1 <= 0) {
-            printf("ERROR: failed sock_udp_recv preconditions\n");
-        }
+        // incoming UDP
+        if (msg_u_in.type == GNRC_NETAPI_MSG_TYPE_RCV) {
+            gnrc_pktsnip_t *pkt = (gnrc_pktsnip_t *)msg_u_in.content.ptr;
+            gnrc_pktsnip_t *ip = gnrc_pktsnip_search_type(pkt, GNRC_NETTYPE_IPV6);
 
-        if ((res = sock_udp_recv(&my_sock, server_buffer,
-                                 sizeof(server_buffer) - 1, 0.05 * US_PER_SEC, //SOCK_NO_TIMEOUT,
-                                 &remote)) < 0) {
-            if (res != 0 && res != -ETIMEDOUT && res != -EAGAIN) {
-                printf("UDP: Error - failed to receive UDP, %d\n", res);
+            bufLen = pkt->size;
+            if (bufLen > sizeof(server_buffer)) {
+                bufLen = sizeof(server_buffer);
             }
-        }
-        else if (res == 0) {
-            (void) puts("UDP: no UDP data received");
-        }
-        else {
-            server_buffer[res] = '\0';
-            res = 1;
-            countMsgIn();
-            ipv6_addr_to_str(ipv6, (ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDRESS_LEN);
-            if (DEBUG == 1) {
-                printf("UDP: recvd: %s from %s\n", server_buffer, ipv6);
+            memcpy(server_buffer, pkt->data, bufLen);
+            bufType = le_wire_type(server_buffer, bufLen);
+            countFrame(STATS_RX, bufType, pkt->size);
+            if (ip != NULL && bufType >= 0) {
+                remote = ((ipv6_hdr_t *)ip->data)->src;
+                int nbr = le_nbr_find(&neighbors, &remote);
+                TRACE(TRACE_RX, bufType, nbr);
+                if (LE_AUTONOMOUS && nbr >= 0) {
+                    neighbors.entries[nbr].heard = xtimer_now_usec(); // any frame shows it is alive
+                    if (topoComplete && (bufType == LE_WIRE_QUERY || bufType == LE_WIRE_ACK)) {
+                        autoStart(leaderPID); // a neighbor settled before us, join it
+                    }
+                }
+                if ((bufType == LE_WIRE_ACK || bufType == LE_WIRE_QUERY || bufType == LE_WIRE_DONE ||
+                     bufType == LE_WIRE_HB) &&
+                    (nbr < 0 || !(neighbors.entries[nbr].link & LE_NBR_IN))) {
+                    // multicast reaches everyone in radio range, keep configured (incoming) links only
+                    messagesFiltered++;
+                } else {
+                    res = 1;
+                    if (bufType != LE_WIRE_SYNC) {
+                        countMsgIn(); // clock beacons are not part of the election
+                    }
+                }
+                if (DEBUG == 1) {
+                    ipv6_addr_to_str(ipv6, &remote, IPV6_ADDRESS_LEN);
+                    printf("UDP: recvd: type %d (%u bytes) from %s%s\n", bufType, (unsigned)bufLen, ipv6,
+                           (res == 1) ? "" : ", not a neighbor");
+                }
             }
+            gnrc_pktbuf_release(pkt);
         }
 
         // react to UDP message
         if (res == 1) {
             // the master is discovering us
-            if (strncmp(server_buffer,"ping",4) == 0) {
-                // acknowledge them discovering us
-                if (!discovered) { 
-                    char msg[5] = "pong";
-                    char *argsMsg[] = { "udp_send", ipv6, portBuf, msg, NULL };
-                    udp_send(4, argsMsg);
-                    strcpy(masterIP, ipv6);
-                    printf("UDP: discovery attempt from master node (%s)\n", masterIP);
-                    if (DEBUG == 1) {
-                        printf("UDP: sent UDP message \"%s\" to %s\n", msg, ipv6);
-                    }
+            if (bufType == LE_WIRE_PING) {
+                // acknowledge them discovering us, after a random backoff
+                le_wire_ping_t ping;
+                if (!LE_AUTONOMOUS && !discovered && !pongPending && decoded(le_wire_decode_ping(server_buffer, bufLen, &ping), bufType)) {
+                    masterIP = remote;
+                    pingTx = ping.tx;
+                    pingRx = xtimer_now_usec();
+                    pongPending = true;
+                    pong_msg.type = PONG_MSG_TYPE;
+                    xtimer_set_msg(&pong_timer, random_uint32() % (LE_PONG_JITTER_USEC + 1), &pong_msg, myPid);
+                    printf("UDP: discovery attempt from master node (%s)\n",
+                           ipv6_addr_to_str(ipv6, &masterIP, IPV6_ADDRESS_LEN));
                 }
 
             // the master acknowledging our acknowledgement
-            } else if (strncmp(server_buffer,"conf",4) == 0) {
-                // processes confirmation
-                discovered = true;
-                strcpy(masterIP, ipv6);
-                printf("UDP: master node (%s) confirmed us\n", masterIP);
-
-            // information about our IP and neighbors
-            } else if (strncmp(server_buffer,"ips:",4) == 0) {
-                // process IP and neighbors
-                ipc_msg_send(server_buffer, leaderPID, false);
-
-                if (!topoComplete) {
-                    char *msg = (char*)calloc(SERVER_BUFFER_SIZE, sizeof(char));
-                    char *mem = msg;
-                    substr(server_buffer, 4, strlen(server_buffer)-4, msg);
-
-                    if (DEBUG == 1) {                    
-                        printf("UDP: server_buffer = %s\n", server_buffer);
-                        printf("UDP: msg = %s\n", msg);
+            } else if (bufType == LE_WIRE_CONF) {
+                // processes confirmation, it carries the offset the master measured
+                le_wire_conf_t conf;
+                if (decoded(le_wire_decode_conf(server_buffer, bufLen, &conf), bufType)) {
+                    discovered = true;
+                    masterIP = remote;
+                    if (!beaconed) {
+                        uint32_t now = xtimer_now_usec();
+                        le_sync_init(&masterClock);
+                        le_sync_sample(&masterClock, now, now - conf.offset);
                     }
+                    printf("UDP: master node (%s) confirmed us, clock offset %"PRId32" us\n",
+                           ipv6_addr_to_str(ipv6, &masterIP, IPV6_ADDRESS_LEN), (int32_t)conf.offset);
+                }
 
-                    extractIP(&msg,mStr);
-                    m = atoi(mStr);
-
-                    extractIP(&msg,myIPv6);
-                    printf("UDP: My IPv6 is: %s, m=%d\n", myIPv6, m);
-
+            // the master's clock, for offset and skew
+            } else if (bufType == LE_WIRE_SYNC) {
+                le_wire_sync_t sync;
+                if (discovered && ipv6_addr_equal(&remote, &masterIP) &&
+                    decoded(le_wire_decode_sync(server_buffer, bufLen, &sync), bufType)) {
+                    if (!beaconed) {
+                        le_sync_init(&masterClock);
+                        beaconed = true;
+                    }
+                    le_sync_sample(&masterClock, xtimer_now_usec(), sync.tx);
                     if (DEBUG == 1) {
-                        printf("UDP: before extract while loop\n");
+                        printf("UDP: clock beacon, offset %"PRId32" us, skew %"PRId32" ppm\n",
+                               (int32_t)masterClock.offset, masterClock.skewPpm);
                     }
-                    // extract neighbors IPs from message
-                    while(strlen(msg) > 1) {
-                        if (DEBUG == 1) {
-                            printf("UDP: top of extract while, strlen(msg)=%d, msg=%s\n", strlen(msg), msg);
-                        }
+                }
 
-                        extractIP(&msg,neighbors[numNeighbors]);
-                        numNeighbors++;
+            // information about our IP and neighbors
+            } else if (bufType == LE_WIRE_IPS) {
+                // process IP and neighbors, the decoded block goes to the protocol thread
+                event = ipc_alloc();
+                if (event != NULL && decoded(le_wire_decode_ips(server_buffer, bufLen, &event->ips), bufType)) {
+                    uint8_t part = event->ips.part;
+                    if (part == ipsNext && !topoComplete) {
+                        m = event->ips.m;
+                        myIPv6 = event->ips.self;
+                        printf("UDP: My IPv6 is: %s, m=%d\n",
+                               ipv6_addr_to_str(ipv6, &myIPv6, IPV6_ADDRESS_LEN), m);
+
+                        // record neighbors IPs from message, large neighborhoods span several frames
+                        uint16_t known = neighbors.count;
+                        bool more = event->ips.more;
+                        for (i = 0; i < event->ips.numNeighbors; i++) {
+                            uint8_t link = ((event->ips.linksIn & (1 << i)) ? LE_NBR_IN : 0) |
+                                           ((event->ips.linksOut & (1 << i)) ? LE_NBR_OUT : 0);
+                            if (le_nbr_add(&neighbors, &event->ips.neighbors[i], link, SERVER_PORT,
+                                           (netif != NULL) ? (uint16_t)netif->pid : 0) < 0) {
+                                printf("UDP: Error - neighbor table full (%d), dropped %s\n", LE_MAX_NEIGHBORS,
+                                       ipv6_addr_to_str(ipv6, &event->ips.neighbors[i], IPV6_ADDRESS_LEN));
+                            }
+                        }
 
-                        if (DEBUG == 1) {
-                            printf("UDP: bottom of extract while, msg=%s, neighbor=%s\n", msg, neighbors[numNeighbors]);
+                        if (ipc_send(leaderPID, IPC_RX_IPS, event) == 1) {
+                            topoComplete = !more;
+                            ipsNext++;
+                        } else {
+                            // the protocol thread never got it, leave the frame unconfirmed and
+                            // forget its new neighbors, the master's retransmission brings them again
+                            printf("UDP: Error - ips frame %u lost to a full queue, waiting for it again\n", part);
+                            while (neighbors.count > known) {
+                                ipv6_addr_t addr = neighbors.entries[neighbors.count - 1].addr;
+                                le_nbr_remove(&neighbors, &addr);
+                            }
                         }
+                    } else {
+                        // a retransmission, its first confirmation was lost
+                        ipc_free(event);
+                    }
+
+                    // confirm every frame we hold, the master retransmits until we do
+                    if (part < ipsNext) {
+                        le_wire_ips_ack_t ipsAck = { .part = part };
+                        len = le_wire_encode_ips_ack(frame, sizeof(frame), &ipsAck);
+                        udp_send_to(&remote, SERVER_PORT, frame, len);
                     }
-                    
-                    topoComplete = true;
-                    free(mem);
+                } else {
+                    ipc_free(event);
                 }
 
             // start leader election
-            } else if (strncmp(server_buffer,"start:",6) == 0) {
-                // start leader election
-                runningLE = true;
-                ipc_msg_send(server_buffer, leaderPID, false);
+            } else if (bufType == LE_WIRE_START) {
+                // start leader election at the master's time, converted to our clock;
+                // the start is multicast several times and only taken once per run,
+                // and only by nodes that hold their whole topology
+                event = ipc_alloc();
+                if (event != NULL && decoded(le_wire_decode_start(server_buffer, bufLen, &event->start), bufType) &&
+                    topoComplete && event->start.epoch != startEpoch) {
+                    startEpoch = event->start.epoch;
+                    int32_t delay = (int32_t)(le_sync_to_local(&masterClock, event->start.startAt) - xtimer_now_usec());
+                    if (delay > 0 && delay <= LE_START_MAX_LEAD_USEC) {
+                        startPending = event;
+                        start_msg.type = START_MSG_TYPE;
+                        start_msg.content.ptr = event;
+                        xtimer_set_msg(&start_timer, (uint32_t)delay, &start_msg, myPid);
+                    } else {
+                        runningLE = true;
+                        ipc_send(leaderPID, IPC_RX_START, event);
+                    }
+                    if (DEBUG == 1) {
+                        printf("UDP: run %u starts in %"PRId32" us\n", startEpoch, delay);
+                    }
+                } else {
+                    ipc_free(event);
+                }
+
+            // the master prepares another run over the same topology
+            } else if (bufType == LE_WIRE_RESET) {
+                le_wire_reset_t reset;
+                if (discovered && ipv6_addr_equal(&remote, &masterIP) &&
+                    decoded(le_wire_decode_reset(server_buffer, bufLen, LE_WIRE_RESET, &reset), bufType)) {
+                    // the first copy resets, every copy is confirmed since ours may be lost
+                    event = (reset.epoch != resetEpoch) ? ipc_alloc() : NULL;
+                    if (event != NULL) {
+                        resetEpoch = reset.epoch;
+                        xtimer_remove(&start_timer);
+                        ipc_free(startPending);
+                        startPending = NULL;
+                        runningLE = false;
+                        messagesIn = 0;
+                        messagesOut = 0;
+                        messagesFiltered = 0;
+                        statsReset();
+                        rconf = 0;
+                        resultsTerm = 0;
+                        event->reset = reset;
+                        ipc_send(leaderPID, IPC_RX_RESET, event);
+                        printf("UDP: reset for run %u\n", reset.epoch);
+                    }
+                    if (reset.epoch == resetEpoch) {
+                        len = le_wire_encode_reset(frame, sizeof(frame), LE_WIRE_RESET_ACK, &reset);
+                        udp_send_to(&masterIP, SERVER_PORT, frame, len);
+                    }
+                }
+
+            // a node in radio range, a neighbor without a master
+            } else if (bufType == LE_WIRE_HELLO) {
+                if (LE_AUTONOMOUS && topoComplete) {
+                    helloHeard(&remote, netif, myPid);
+                }
+
+            // this neighbor is asking for our leader election values
+            } else if (bufType == LE_WIRE_QUERY) {
+                event = ipc_alloc();
+                if (event != NULL && decoded(le_wire_decode_query(server_buffer, bufLen, &event->query), bufType)) {
+                    event->src = remote;
+                    ipc_send(leaderPID, IPC_RX_QUERY, event);
+                } else {
+                    ipc_free(event);
+                }
 
             // this neighbor is sending us leader election values
-            } else if (strncmp(server_buffer,"le_ack",6) == 0 || strncmp(server_buffer,"le_m?",5) == 0) {
+            } else if (bufType == LE_WIRE_ACK) {
                 // process m value things
-                ipc_msg_send(server_buffer, leaderPID, false);
-                if (DEBUG == 1) {
-                    printf("UDP: sent IPC message \"%s\" to %" PRIkernel_pid "\n", server_buffer, leaderPID);
+                event = ipc_alloc();
+                if (event != NULL && decoded(le_wire_decode_ack(server_buffer, bufLen, &event->ack), bufType)) {
+                    event->src = remote;
+                    ipc_send(leaderPID, IPC_RX_ACK, event);
+                    if (DEBUG == 1) {
+                        printf("UDP: sent le_ack event to %" PRIkernel_pid "\n", leaderPID);
+                    }
+                } else {
+                    ipc_free(event);
+                }
+
+            // this neighbor finished the election
+            } else if (bufType == LE_WIRE_DONE) {
+                event = ipc_alloc();
+                if (event != NULL && decoded(le_wire_decode_done(server_buffer, bufLen, &event->done), bufType)) {
+                    event->src = remote;
+                    ipc_send(leaderPID, IPC_RX_DONE, event);
+                } else {
+                    ipc_free(event);
                 }
-            } else if (strncmp(server_buffer,"rconf",5) == 0) {
+
+            // the leader is alive, passed on by a neighbor
+            } else if (bufType == LE_WIRE_HB) {
+                event = ipc_alloc();
+                if (event != NULL && decoded(le_wire_decode_hb(server_buffer, bufLen, &event->hb), bufType)) {
+                    event->src = remote;
+                    ipc_send(leaderPID, IPC_RX_HB, event);
+                } else {
+                    ipc_free(event);
+                }
+            } else if (bufType == LE_WIRE_RCONF) {
                 // process m value things
                 rconf = 1;
                 if (DEBUG == 1) {
                     printf("UDP: master confirmed results");
                 }
             }
+            continue;
         }
 
-        // incoming thread message
-        memset(msg_content, 0, MAX_IPC_MESSAGE_SIZE);
-        res = msg_try_receive(&msg_u_in);
-        if (res == 1) {
-            if (msg_u_in.type > 0 && msg_u_in.type < MAX_IPC_MESSAGE_SIZE) {
-                // process string message of size msg_u_in.type
-                strncpy(msg_content, (char*)msg_u_in.content.ptr, (uint16_t)msg_u_in.type+1);
-                if (DEBUG == 1) {
-                    printf("UDP: received IPC message: %s from %" PRIkernel_pid ", type=%d\n", msg_content, msg_u_in.sender_pid, msg_u_in.type);
-                }
-            } else {
-                printf("UPD: received an illegal or too large IPC message, type=%u", msg_u_in.type);
+        // backoff of a pong is over, unless the master confirmed us meanwhile
+        if (msg_u_in.type == PONG_MSG_TYPE) {
+            TRACE(TRACE_TIMER, TRACE_TIMER_PONG, 0);
+            pongPending = false;
+            if (!discovered) {
+                le_wire_pong_t pong = { .pingTx = pingTx, .rx = pingRx, .tx = xtimer_now_usec() };
+                len = le_wire_encode_pong(frame, sizeof(frame), &pong);
+                udp_send_to(&masterIP, SERVER_PORT, frame, len);
             }
+            continue;
         }
 
-        // react to thread message
-        if (res == 1) {
-            // start a leader election run
-            if (strncmp(msg_content,"le_init",7) == 0) {
-                // send out m? queries
-                char msg[7] = "le_m?:";
+        // the scheduled start time has come, unless a reset cancelled it
+        if (msg_u_in.type == START_MSG_TYPE) {
+            if (msg_u_in.content.ptr == startPending) {
+                TRACE(TRACE_TIMER, TRACE_TIMER_START, 0);
+                startPending = NULL;
                 runningLE = true;
+                ipc_send(leaderPID, IPC_RX_START, (ipc_event_t *)msg_u_in.content.ptr);
+            }
+            continue;
+        }
 
-                for(i = 0; i < numNeighbors; i++) {
-                    char *argsMsg[] = { "udp_send", neighbors[i], portBuf, msg, NULL };
-                    udp_send(4, argsMsg);
-                    xtimer_usleep(10000); // wait 0.01 seconds
-                }
-
-                if (DEBUG == 1) {
-                    printf("UDP: sent UDP message \"%s\" to %d neighbors\n", msg, numNeighbors);
+        // Trickle timer of the hellos, ignore one that was replaced
+        if (msg_u_in.type == HELLO_MSG_TYPE) {
+            if (msg_u_in.content.value == helloGen) {
+                TRACE(TRACE_TIMER, TRACE_TIMER_HELLO, 0);
+                bool transmit;
+                helloArm(le_trickle_expire(&helloTrickle, random_uint32(), &transmit), myPid);
+                if (transmit) {
+                    len = le_wire_encode(frame, sizeof(frame), LE_WIRE_HELLO);
+                    if (len > 0) {
+                        udp_send_multicast(SERVER_PORT, frame, len);
+                    }
                 }
-    
-            // send out an m value acknowledgement
-            } else if (strncmp(msg_content,"le_ack",6) == 0) {
-                // send out m value
-                for(i = 0; i < numNeighbors; i++) {
-                    char *argsMsg[] = { "udp_send", neighbors[i], portBuf, msg_content, NULL };
-                    udp_send(4, argsMsg);
-                    xtimer_usleep(10000); // wait 0.01 seconds
+                helloAge(myPid);
+                if (xtimer_now_usec() - nbrChanged >= LE_AUTO_SETTLE_USEC) {
+                    autoStart(leaderPID);
                 }
+            }
+            continue;
+        }
 
-                if (DEBUG == 1) {
-                    printf("UDP: sent UDP message \"%s\" to %d neighbors\n", msg_content, numNeighbors);
-                }
+        // pacing timer of a unicast fan-out, ignore one that was replaced
+        if (msg_u_in.type == FANOUT_MSG_TYPE) {
+            if (msg_u_in.content.value == fanoutGen) {
+                TRACE(TRACE_TIMER, TRACE_TIMER_FANOUT, 0);
+                fanoutStep(myPid);
+            }
+            continue;
+        }
+
+        // incoming thread message, an event to send out for the protocol thread
+        if (!IPC_OWNS_EVENT(msg_u_in.type)) {
+            if (msg_u_in.type != GNRC_NETAPI_MSG_TYPE_RCV) {
+                printf("UPD: received an illegal IPC message, type=0x%04x\n", msg_u_in.type);
+            }
+            continue;
+        }
+        event = (ipc_event_t *)msg_u_in.content.ptr;
+        if (DEBUG == 1) {
+            printf("UDP: received IPC event 0x%04x from %" PRIkernel_pid "\n", msg_u_in.type, msg_u_in.sender_pid);
+        }
 
-            // leader election complete, print network stats
-            } else if (strncmp(msg_content,"results",7) == 0 && rconf == 0) {
-                // leader election finished!
-                printf("UDP: leader election complete, msgsIn: %d, msgsOut: %d, msgsTotal: %d\n", messagesIn, messagesOut, messagesIn + messagesOut);
+        // react to thread message
+        // start a leader election run
+        if (msg_u_in.type == IPC_TX_QUERY) {
+            // send out m? queries
+            runningLE = true;
 
-                // send information to the master node
-				char *msg = (char*)malloc(SERVER_BUFFER_SIZE);
-                memset(msg, 0, SERVER_BUFFER_SIZE);
-                char *mem = msg;
+            len = le_wire_encode_query(frame, sizeof(frame), &event->query);
+            fanout(frame, len, myPid);
 
-                //chop off the results string
-				substr(msg_content, 8, strlen(msg_content)-8, msg);
-                if (DEBUG == 1) {
-                    printf("UDP: results body: %s\n", msg);
-                }
+            if (DEBUG == 1) {
+                printf("UDP: sending le_m? to %d neighbors%s\n", neighbors.count, useMulticast ? " by multicast" : "");
+            }
 
-				//Extract the elected IP
-				extractIP(&msg, tempipv6);
-                if (DEBUG == 1) {
-                    printf("UDP: extracted leader %s\n", tempipv6);
-                }
+        // send out an m value acknowledgement
+        } else if (msg_u_in.type == IPC_TX_ACK) {
+            // send out m value
+            len = le_wire_encode_ack(frame, sizeof(frame), &event->ack);
+            fanout(frame, len, myPid);
 
-				//Extract the convergance time
-				extractIP(&msg, convTime);
-                if (DEBUG == 1) {
-                    printf("UDP: extracted convergence time: %s\n", convTime);
-                }
+            if (DEBUG == 1) {
+                printf("UDP: sending le_ack to %d neighbors%s\n", neighbors.count, useMulticast ? " by multicast" : "");
+            }
 
-				//Setup message to send to master node
-				//Form is "results;<elected_leader_id>;<runtime>;<message_count>;"
-                free(mem);
-				char msg2[SERVER_BUFFER_SIZE] = "results:";
-                
-                strcat(msg2, tempipv6);
-                strcat(msg2, ";");
-                strcat(msg2, convTime);//convTime is already a string from the other thread
-                strcat(msg2, ";");
-				
-				int totalMessages = messagesIn + messagesOut;
-				//TODO convert totalMessages to char array
-				char tempMessages[10];
-				sprintf(tempMessages , "%d" , totalMessages);
-                strcat(msg2, tempMessages);
-                strcat(msg2, ";");
-                if (DEBUG == 1) {
-                    printf("UDP: sending results to master: %s\n", msg2);
-                }
-                char *argsMsg[] = { "udp_send", masterIP, portBuf, msg2, NULL };
-                udp_send(4, argsMsg);
-                xtimer_usleep(1500000); // wait 1.5 seconds
+        // pass the completion wave on
+        } else if (msg_u_in.type == IPC_TX_DONE) {
+            len = le_wire_encode_done(frame, sizeof(frame), &event->done);
+            fanout(frame, len, myPid);
+
+            if (DEBUG == 1) {
+                printf("UDP: sending le_done to %d neighbors%s\n", neighbors.count, useMulticast ? " by multicast" : "");
             }
-        }
 
-        xtimer_usleep(50000); // wait 0.05 seconds
+        // start or pass on a leader heartbeat
+        } else if (msg_u_in.type == IPC_TX_HB) {
+            len = le_wire_encode_hb(frame, sizeof(frame), &event->hb);
+            fanout(frame, len, myPid);
+
+        // leader election complete, print network stats
+        } else if (msg_u_in.type == IPC_TX_RESULTS && (rconf == 0 || event->results.term != resultsTerm)) {
+            resultsTerm = event->results.term;
+            // leader election finished!
+            printf("UDP: leader election complete, msgsIn: %d, msgsOut: %d, msgsTotal: %d, filtered: %d, mode: %s\n",
+                   messagesIn, messagesOut, messagesIn + messagesOut, messagesFiltered,
+                   useMulticast ? "multicast" : "unicast");
+
+            // send information to the master node, adding our message count,
+            // and the start and end in the master's clock so it can relate all nodes
+            event->results.messages = messagesIn + messagesOut;
+            statsReport(&event->results.stats);
+            event->results.started = le_sync_to_master(&masterClock, event->results.started);
+            event->results.ended = le_sync_to_master(&masterClock, event->results.ended);
+            len = le_wire_encode_results(frame, sizeof(frame), &event->results);
+            if (DEBUG == 1) {
+                printf("UDP: sending results to master: %s;%"PRIu32";%"PRIu32"\n",
+                       ipv6_addr_to_str(ipv6, &event->results.leader, IPV6_ADDRESS_LEN),
+                       event->results.convergence, event->results.messages);
+            }
+            if (len > 0 && discovered) {
+                udp_send_to(&masterIP, SERVER_PORT, frame, len);
+            }
+        }
+        ipc_free(event);
     }
 
     return NULL;
 }
 
+// Purpose: send a buffer to a specific target
+//
+// addr ipv6_addr_t*, the destination address
+// port uint16_t, the destination port
+// data void*, the payload
+// len size_t, length of the payload
+int udp_send_to(const ipv6_addr_t *addr, uint16_t port, const void *data, size_t len)
+{
+    sock_udp_ep_t remote = { .family = AF_INET6 };
+
+    memcpy(remote.addr.ipv6, addr, sizeof(remote.addr.ipv6));
+    if (ipv6_addr_is_link_local(addr)) {
+        /* choose first interface when address is link local */
+        gnrc_netif_t *netif = gnrc_netif_iter(NULL);
+        remote.netif = (uint16_t)netif->pid;
+    }
+    remote.port = port;
+    return udp_send_ep(&remote, data, len);
+}
+
+// Purpose: send a buffer to an already resolved endpoint, e.g. a cached neighbor
+//
+// remote sock_udp_ep_t*, the destination endpoint
+// data void*, the payload
+// len size_t, length of the payload
+int udp_send_ep(const sock_udp_ep_t *remote, const void *data, size_t len)
+{
+    int res;
+    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
+
+    int type = le_wire_type(data, len);
+
+    if((res = sock_udp_send(NULL, data, len, remote)) < 0) {
+        countSendFail(type);
+        printf("UDP: Error - could not send message to %s\n",
+               ipv6_addr_to_str(ipv6, (const ipv6_addr_t *)remote->addr.ipv6, IPV6_ADDRESS_LEN));
+        return -1;
+    }
+    else {
+        if (DEBUG == 1) {
+            printf("UDP: Success - sent %u bytes to %s\n", (unsigned) res,
+                   ipv6_addr_to_str(ipv6, (const ipv6_addr_t *)remote->addr.ipv6, IPV6_ADDRESS_LEN));
+        }
+        countMsgOut();
+        countFrame(STATS_TX, type, len);
+        TRACE(TRACE_TX, type, le_nbr_find(&neighbors, (const ipv6_addr_t *)remote->addr.ipv6));
+    }
+    return 0;
+}
+
+// Purpose: send a buffer to all nodes on the link, FF02::1
+//
+// port uint16_t, the destination port
+// data void*, the payload
+// len size_t, length of the payload
+int udp_send_multicast(uint16_t port, const void *data, size_t len)
+{
+    ipv6_addr_t addr;
+    ipv6_addr_set_all_nodes_multicast(&addr, IPV6_ADDR_MCAST_SCP_LINK_LOCAL);
+    return udp_send_to(&addr, port, data, len);
+}
+
 // Purpose: send a message to a specific target
 //
 // argc int, number of arguments (should be 4)
 // argv char**, list of arugments ("udp", <target-ipv6>, <port>, <message>)
 int udp_send(int argc, char **argv)
 {
-    int res;
-    sock_udp_ep_t remote = { .family = AF_INET6 };
+    ipv6_addr_t addr;
 
     if (argc != 4) {
         (void) puts("UDP: Usage - udp <ipv6-addr> <port> <payload>");
         return -1;
     }
 
-    if (ipv6_addr_from_str((ipv6_addr_t *)&remote.addr, argv[1]) == NULL) {
+    if (ipv6_addr_from_str(&addr, argv[1]) == NULL) {
         (void) puts("UDP: Error - unable to parse destination address");
         return 1;
     }
-    if (ipv6_addr_is_link_local((ipv6_addr_t *)&remote.addr)) {
-        /* choose first interface when address is link local */
-        gnrc_netif_t *netif = gnrc_netif_iter(NULL);
-        remote.netif = (uint16_t)netif->pid;
-    }
-    remote.port = atoi(argv[2]);
-    if((res = sock_udp_send(NULL, argv[3], strlen(argv[3]), &remote)) < 0) {
-        printf("UDP: Error - could not send message \"%s\" to %s\n", argv[3], argv[1]);
-    }
-    else {
-        if (DEBUG == 1) {
-            printf("UDP: Success - sent %u bytes to %s\n", (unsigned) res, argv[1]);
-        }
-        countMsgOut();
-    }
+    udp_send_to(&addr, atoi(argv[2]), argv[3], strlen(argv[3]));
     return 0;
 }
 
@@ -422,34 +1005,69 @@ int udp_send(int argc, char **argv)
 // argv char**, list of arugments ("udp", <port>, <message>)
 int udp_send_multi(int argc, char **argv)
 {
-    //multicast: FF02::1
-    int res;
-    sock_udp_ep_t remote = { .family = AF_INET6 };
-    char ipv6[IPV6_ADDRESS_LEN] = { 0 };
-
     if (argc != 3) {
         (void) puts("UDP: Usage - udp <port> <payload>");
         return -1;
     }
 
-    ipv6_addr_set_all_nodes_multicast((ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDR_MCAST_SCP_LINK_LOCAL);
+    udp_send_multicast(atoi(argv[1]), argv[2], strlen(argv[2]));
+    return 0;
+}
 
-    if (ipv6_addr_is_link_local((ipv6_addr_t *)&remote.addr)) {
-        /* choose first interface when address is link local */
-        gnrc_netif_t *netif = gnrc_netif_iter(NULL);
-        remote.netif = (uint16_t)netif->pid;
+// Purpose: show or select how le_m? and le_ack reach the neighbors
+//
+// argc int, number of arguments (1 or 2)
+// argv char**, list of arguments ("lemode", [unicast|multicast])
+int udp_mode(int argc, char **argv)
+{
+    if (argc == 2 && strcmp(argv[1], "unicast") == 0) {
+        useMulticast = false;
+    } else if (argc == 2 && strcmp(argv[1], "multicast") == 0) {
+        useMulticast = true;
+    } else if (argc != 1) {
+        (void) puts("UDP: Usage - lemode [unicast|multicast]");
+        return -1;
     }
-    remote.port = atoi(argv[1]);
-    ipv6_addr_to_str(ipv6, (ipv6_addr_t *)&remote.addr.ipv6, IPV6_ADDRESS_LEN);
-    if((res = sock_udp_send(NULL, argv[2], strlen(argv[2]), &remote)) < 0) {
-        printf("UDP: Error - could not send message \"%s\" to %s\n", argv[2], ipv6);
+
+    printf("UDP: dissemination mode is %s\n", useMulticast ? "multicast" : "unicast");
+    return 0;
+}
+
+// Purpose: print the traffic counters by message type and start them from
+// zero, the results report carries them folded into classes
+//
+// argc int, number of arguments (should be 1)
+// argv char**, list of arguments ("lestats")
+int udp_stats(int argc, char **argv)
+{
+    (void)argv;
+    type_stats_t snapshot[LE_WIRE_TYPES];
+    ipc_stats_t ipc;
+
+    if (argc != 1) {
+        (void) puts("UDP: Usage - lestats");
+        return -1;
     }
-    else {
-        if (DEBUG == 1) {
-            printf("UDP: Success - sent %u bytes to %s\n", (unsigned)res, ipv6);
+
+    mutex_lock(&statsLock);
+    memcpy(snapshot, typeStats, sizeof(snapshot));
+    memset(typeStats, 0, sizeof(typeStats));
+    mutex_unlock(&statsLock);
+    ipc_stats(&ipc, true);
+
+    printf("UDP: %-9s %8s %10s %8s %10s %9s %9s\n", "type", "rx", "rx bytes", "tx", "tx bytes",
+           "send fail", "parse err");
+    for (int i = 0; i < LE_WIRE_TYPES; i++) {
+        const type_stats_t *t = &snapshot[i];
+        if (t->frames[STATS_RX] + t->frames[STATS_TX] + t->sendFail + t->parseErr == 0) {
+            continue;
         }
-        countMsgOut();
+        printf("UDP: %-9s %8"PRIu32" %10"PRIu32" %8"PRIu32" %10"PRIu32" %9"PRIu32" %9"PRIu32"\n",
+               le_wire_type_name(i), t->frames[STATS_RX], t->bytes[STATS_RX], t->frames[STATS_TX],
+               t->bytes[STATS_TX], t->sendFail, t->parseErr);
     }
+    printf("UDP: IPC events dropped %"PRIu32", pool exhausted %"PRIu32", %d frames filtered\n",
+           ipc.dropped, ipc.exhausted, messagesFiltered);
     return 0;
 }
 